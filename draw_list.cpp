@@ -0,0 +1,260 @@
+#include "draw_list.h"
+#include "text.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace frame {
+
+	// command keys: layer and z biased to unsigned in the top two 16-bit fields,
+	// then 8 bits of recorder index and 24 bits of record order
+	static const int recorderShift = 24;
+	static const uint32_t sequenceMask = (1u << recorderShift) - 1;
+	static const int maxRecorders = 256;
+
+	static inline uint64_t biased(int value) {
+		return (uint64_t)(std::min(std::max(value, -32768), 32767) + 32768);
+	}
+
+	static inline bool intersects(const Rect& a, int width, int height) {
+		return a.width > 0 && a.height > 0 && a.x < width && a.y < height && a.x + a.width > 0 && a.y + a.height > 0;
+	}
+
+	static inline bool sameColor(const RGBColor& a, const RGBColor& b) {
+		return a.red == b.red && a.green == b.green && a.blue == b.blue;
+	}
+
+	// true and the union in into when the two rectangles share a full edge
+	// span and touch or overlap, so their union is a rectangle itself
+	static bool joinRects(Rect& into, const Rect& rect) {
+		if (rect.y == into.y && rect.height == into.height && rect.x <= into.x + into.width && rect.x + rect.width >= into.x) {
+			int minX = std::min(into.x, rect.x);
+			into.width = std::max(into.x + into.width, rect.x + rect.width) - minX;
+			into.x = minX;
+			return true;
+		}
+
+		if (rect.x == into.x && rect.width == into.width && rect.y <= into.y + into.height && rect.y + rect.height >= into.y) {
+			int minY = std::min(into.y, rect.y);
+			into.height = std::max(into.y + into.height, rect.y + rect.height) - minY;
+			into.y = minY;
+			return true;
+		}
+
+		return false;
+	}
+
+	DrawList::Command& DrawList::Recorder::record(CommandType type, const Rect& bounds, const RGBColor& color, int layer, int z) {
+		commands.emplace_back();
+		Command& command = commands.back();
+		command.key = biased(layer) << 48 | biased(z) << 32 | ((uint32_t)(commands.size() - 1) & sequenceMask);
+		command.type = type;
+		command.antiAliased = antiAliasing;
+		command.color = color;
+		command.bounds = bounds;
+		command.object = nullptr;
+		return command;
+	}
+
+	void DrawList::Recorder::fillRectangle(const Rect& rect, const RGBColor& color, int layer, int z) {
+		record(CommandType::Rectangle, rect, color, layer, z);
+	}
+
+	void DrawList::Recorder::drawLine(int x0, int y0, int x1, int y1, const RGBColor& color, int layer, int z) {
+		// one pixel of slack around the end pixels for the anti-aliased quad
+		int minX = std::min(x0, x1) - 1, minY = std::min(y0, y1) - 1;
+		Rect bounds = { minX, minY, std::max(x0, x1) + 2 - minX, std::max(y0, y1) + 2 - minY };
+
+		Command& command = record(CommandType::Line, bounds, color, layer, z);
+		command.values[0] = x0;
+		command.values[1] = y0;
+		command.values[2] = x1;
+		command.values[3] = y1;
+	}
+
+	void DrawList::Recorder::drawEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color, int layer, int z) {
+		Rect bounds = { centerX - radiusX - 1, centerY - radiusY - 1, 2 * radiusX + 3, 2 * radiusY + 3 };
+
+		Command& command = record(CommandType::Ellipse, bounds, color, layer, z);
+		command.values[0] = centerX;
+		command.values[1] = centerY;
+		command.values[2] = radiusX;
+		command.values[3] = radiusY;
+	}
+
+	void DrawList::Recorder::fillEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color, int layer, int z) {
+		Rect bounds = { centerX - radiusX - 1, centerY - radiusY - 1, 2 * radiusX + 3, 2 * radiusY + 3 };
+
+		Command& command = record(CommandType::FilledEllipse, bounds, color, layer, z);
+		command.values[0] = centerX;
+		command.values[1] = centerY;
+		command.values[2] = radiusX;
+		command.values[3] = radiusY;
+	}
+
+	void DrawList::Recorder::fillPolygon(const Point* polygon, int count, const RGBColor& color, int layer, int z) {
+		if (count < 3)
+			return;
+
+		int minX = polygon[0].x, minY = polygon[0].y, maxX = minX, maxY = minY;
+		for (int i = 1; i < count; i++) {
+			minX = std::min(minX, polygon[i].x);
+			minY = std::min(minY, polygon[i].y);
+			maxX = std::max(maxX, polygon[i].x);
+			maxY = std::max(maxY, polygon[i].y);
+		}
+
+		Command& command = record(CommandType::Polygon, { minX - 1, minY - 1, maxX + 3 - minX, maxY + 3 - minY }, color, layer, z);
+		command.offset = (uint32_t)points.size();
+		command.count = (uint32_t)count;
+		points.insert(points.end(), polygon, polygon + count);
+	}
+
+	void DrawList::Recorder::drawImage(const Image& image, int x, int y, int layer, int z, BlendMode mode, int flip) {
+		drawImage(image, { 0, 0, image.width, image.height }, { x, y, image.width, image.height }, layer, z, mode, flip);
+	}
+
+	void DrawList::Recorder::drawImage(const Image& image, const Rect& source, const Rect& dest, int layer, int z, BlendMode mode, int flip) {
+		Command& command = record(CommandType::Image, dest, {}, layer, z);
+		command.object = &image;
+		command.source = source;
+		command.mode = mode;
+		command.flip = flip;
+	}
+
+	void DrawList::Recorder::drawString(const Font& font, const char* string, int x, int y, const RGBColor& color, int layer, int z) {
+		// bounds from the cell grid: Font::measure goes through the font's layout
+		// cache, which recorders on other threads may not touch
+		size_t length = strlen(string);
+		int lines = length ? 1 : 0;
+		int columns = 0, column = 0;
+		for (size_t i = 0; i < length; i++) {
+			if (string[i] == '\n') {
+				lines++;
+				column = 0;
+			}
+			else {
+				columns = std::max(columns, ++column);
+			}
+		}
+
+		Rect bounds = { x, y, columns * font.getCellWidth(), lines * font.getLineHeight() };
+		Command& command = record(CommandType::String, bounds, color, layer, z);
+		command.object = &font;
+		command.values[0] = x;
+		command.values[1] = y;
+		command.offset = (uint32_t)text.size();
+		command.count = (uint32_t)length;
+		text.insert(text.end(), string, string + length + 1);
+	}
+
+	void DrawList::setRecorderCount(int count) {
+		recorders.resize(std::min(std::max(count, 1), maxRecorders));
+	}
+
+	void DrawList::clear() {
+		for (Recorder& recorder : recorders)
+			recorder.reset();
+	}
+
+	void DrawList::submit() {
+		Renderer& renderer = Renderer::getInstance();
+		int width = renderer.buffer.width;
+		int height = renderer.buffer.height;
+
+		stats = {};
+		order.clear();
+
+		for (size_t index = 0; index < recorders.size(); index++) {
+			const Recorder& recorder = recorders[index];
+			stats.recorded += (uint32_t)recorder.commands.size();
+
+			for (const Command& command : recorder.commands) {
+				if (!intersects(command.bounds, width, height)) {
+					stats.culled++;
+					continue;
+				}
+				order.push_back({ command.key | (uint64_t)index << recorderShift, &command });
+			}
+		}
+
+		// keys are unique, so this keeps record order within a layer and z
+		std::sort(order.begin(), order.end(), [](const std::pair<uint64_t, const Command*>& a, const std::pair<uint64_t, const Command*>& b) {
+			return a.first < b.first;
+		});
+
+		bool antiAliasing = renderer.antiAliasing;
+
+		// rectangles are held back while the ones after them in draw order have
+		// the same color and extend them to a larger rectangle
+		Rect pending = {};
+		RGBColor pendingColor = {};
+		bool hasPending = false;
+
+		for (const std::pair<uint64_t, const Command*>& entry : order) {
+			const Command& command = *entry.second;
+
+			if (command.type == CommandType::Rectangle) {
+				if (hasPending && sameColor(command.color, pendingColor) && joinRects(pending, command.bounds)) {
+					stats.merged++;
+					continue;
+				}
+
+				if (hasPending) {
+					Renderer::FillRectangle(pending, pendingColor);
+					stats.drawn++;
+				}
+				pending = command.bounds;
+				pendingColor = command.color;
+				hasPending = true;
+				continue;
+			}
+
+			if (hasPending) {
+				Renderer::FillRectangle(pending, pendingColor);
+				stats.drawn++;
+				hasPending = false;
+			}
+
+			execute(recorders[(entry.first >> recorderShift) & (maxRecorders - 1)], command);
+			stats.drawn++;
+		}
+
+		if (hasPending) {
+			Renderer::FillRectangle(pending, pendingColor);
+			stats.drawn++;
+		}
+
+		renderer.antiAliasing = antiAliasing;
+		clear();
+	}
+
+	void DrawList::execute(const Recorder& recorder, const Command& command) {
+		Renderer::getInstance().antiAliasing = command.antiAliased;
+		const int* values = command.values;
+
+		switch (command.type) {
+		case CommandType::Line:
+			Renderer::DrawLine(values[0], values[1], values[2], values[3], command.color);
+			break;
+		case CommandType::Ellipse:
+			Renderer::DrawEllipse(values[0], values[1], values[2], values[3], command.color);
+			break;
+		case CommandType::FilledEllipse:
+			Renderer::FillEllipse(values[0], values[1], values[2], values[3], command.color);
+			break;
+		case CommandType::Polygon:
+			Renderer::FillPolygon(recorder.points.data() + command.offset, (int)command.count, command.color);
+			break;
+		case CommandType::Image:
+			Renderer::DrawImage(*(const Image*)command.object, command.source, command.bounds, command.mode, command.flip);
+			break;
+		case CommandType::String:
+			Renderer::DrawString(*(const Font*)command.object, recorder.text.data() + command.offset, values[0], values[1], command.color);
+			break;
+		case CommandType::Rectangle:
+			Renderer::FillRectangle(command.bounds, command.color);
+			break;
+		}
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "renderer.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace frame {
+
+	// Retained 2D draw list. Commands are recorded into recorders whose storage
+	// is kept from frame to frame, then submit culls them against the buffer,
+	// sorts them by layer, then z, then record order, merges runs of same
+	// colored rectangles that join into one, and draws the rest in one pass.
+	//
+	// Each recorder belongs to one thread at a time; different recorders may
+	// record concurrently, e.g. recorder i from task i of a WorkerPool
+	// parallelFor. Commands of equal layer and z draw in recorder index order,
+	// then in the order they were recorded, so the result does not depend on
+	// thread timing. layer and z range over -32768 .. 32767, a recorder holds
+	// up to 2^24 commands per frame, and images and fonts must stay alive until
+	// submit.
+	class DrawList {
+	public:
+		struct Stats {
+			uint32_t recorded = 0;
+			uint32_t culled = 0;	// entirely outside the buffer
+			uint32_t merged = 0;	// rectangles folded into a neighbour
+			uint32_t drawn = 0;
+		};
+
+	private:
+		enum class CommandType : uint8_t {
+			Rectangle,
+			Line,
+			Ellipse,
+			FilledEllipse,
+			Polygon,
+			Image,
+			String
+		};
+
+		struct Command {
+			uint64_t key;		// layer, z and record order; the recorder is added by submit
+			CommandType type;
+			bool antiAliased;
+			BlendMode mode;
+			int flip;
+			RGBColor color;
+			Rect bounds;		// conservative, for culling
+			Rect source;		// image source rect
+			int values[4];		// line ends, or ellipse center and radii, or string position
+			const void* object;	// Image or Font
+			uint32_t offset, count; // points or characters in the recorder's arena
+		};
+
+	public:
+		class Recorder {
+			friend class DrawList;
+
+		public:
+			// applies to the lines, ellipses and polygons recorded after it
+			inline void setAntiAliasing(bool enabled) { antiAliasing = enabled; }
+
+			void fillRectangle(const Rect& rect, const RGBColor& color, int layer = 0, int z = 0);
+
+			void drawLine(int x0, int y0, int x1, int y1, const RGBColor& color, int layer = 0, int z = 0);
+
+			inline void drawCircle(int centerX, int centerY, int radius, const RGBColor& color, int layer = 0, int z = 0) {
+				drawEllipse(centerX, centerY, radius, radius, color, layer, z);
+			}
+
+			inline void fillCircle(int centerX, int centerY, int radius, const RGBColor& color, int layer = 0, int z = 0) {
+				fillEllipse(centerX, centerY, radius, radius, color, layer, z);
+			}
+
+			void drawEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color, int layer = 0, int z = 0);
+
+			void fillEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color, int layer = 0, int z = 0);
+
+			// the points are copied
+			void fillPolygon(const Point* points, int count, const RGBColor& color, int layer = 0, int z = 0);
+
+			void drawImage(const Image& image, int x, int y, int layer = 0, int z = 0, BlendMode mode = BlendMode::Alpha, int flip = FLIP_NONE);
+
+			void drawImage(const Image& image, const Rect& source, const Rect& dest, int layer = 0, int z = 0, BlendMode mode = BlendMode::Alpha, int flip = FLIP_NONE);
+
+			// the text is copied
+			void drawString(const Font& font, const char* text, int x, int y, const RGBColor& color, int layer = 0, int z = 0);
+
+			inline size_t size() const { return commands.size(); }
+
+		private:
+			std::vector<Command> commands;
+			std::vector<Point> points;
+			std::vector<char> text;
+			bool antiAliasing = false;
+
+			Command& record(CommandType type, const Rect& bounds, const RGBColor& color, int layer, int z);
+
+			inline void reset() { commands.clear(); points.clear(); text.clear(); }
+		};
+
+		explicit DrawList(int recorderCount = 1) { setRecorderCount(recorderCount); }
+
+		// at most 256; not while recording
+		void setRecorderCount(int count);
+
+		inline int getRecorderCount() const { return (int)recorders.size(); }
+
+		inline Recorder& getRecorder(int index = 0) { return recorders[index]; }
+
+		// draws everything recorded since the last submit and empties the recorders
+		void submit();
+
+		// empties the recorders without drawing
+		void clear();
+
+		// counts of the last submit
+		inline const Stats& getStats() const { return stats; }
+
+	private:
+		std::vector<Recorder> recorders;
+		std::vector<std::pair<uint64_t, const Command*>> order;
+		Stats stats;
+
+		void execute(const Recorder& recorder, const Command& command);
+	};
+}
@@ -2,12 +2,18 @@
 
 #define INVENTORY_ON true
 
-#include <windows.h>
+#include "platform.h"
 #include "game.h"
 #include "renderer.h"
 #include "vectors.h"
 #include "physics.h"
 #include "input.h"
 #include "objects.h"
+#include "text.h"
+#include "draw_list.h"
 
+#if defined(FRAME_PLATFORM_WIN32)
 #define frame_app_entry_point INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nCmdShow)
+#else
+#define frame_app_entry_point int main()
+#endif
@@ -10,6 +10,7 @@ namespace frame {
 		windowHeight = 720;
 	}
 
+#if defined(FRAME_PLATFORM_WIN32)
 	// handles window events
 	LRESULT CALLBACK WindowCallBack(
 		HWND windowHandle,
@@ -22,12 +23,12 @@ namespace frame {
 		switch (message) {
 			case WM_CLOSE: {
 				Game::getInstance().running = false;
-				OutputDebugString(L"window close\n");
+				Platform::debugOutput(L"window close\n");
 			}break;
 
 			case WM_DESTROY: {
 				Game::getInstance().running = false;
-				OutputDebugString(L"window destroy\n");
+				Platform::debugOutput(L"window destroy\n");
 			}break;
 
 			case WM_SYSKEYDOWN:
@@ -45,7 +46,7 @@ namespace frame {
 
 
 			case WM_PAINT: {
-				OutputDebugString(L"window paint\n");
+				Platform::debugOutput(L"window paint\n");
 				
 				PAINTSTRUCT paint;
 				HDC device_context = BeginPaint(windowHandle, &paint);
@@ -53,7 +54,10 @@ namespace frame {
 				int width, height;
 				Renderer::getWindowDimensions(&width, &height);
 
-				Renderer::copyBufferToWindow(device_context, width, height);
+				{
+					std::lock_guard<std::mutex> lock(Renderer::getInstance().bufferMutex);
+					Renderer::copyBufferToWindow(device_context, width, height);
+				}
 
 				EndPaint(windowHandle, &paint);
 			}break;
@@ -78,7 +82,7 @@ namespace frame {
 		windowClass.lpszClassName = className;
 
 		if (!RegisterClass(&windowClass)) {
-			OutputDebugString(L"Failed to register window class\n");
+			Platform::debugOutput(L"Failed to register window class\n");
 			return;
 		}
 
@@ -98,50 +102,179 @@ namespace frame {
 		);
 
 		if (windowHandle) {
-			OutputDebugString(L"GAME INIT\n");
+			Platform::debugOutput(L"GAME INIT\n");
 			running = true;
 
 			Renderer::setWindowHandle(windowHandle);
 
-			// init the clock
-			auto lastFrameTime = std::chrono::high_resolution_clock::now();
+			runLoop();
+		}
+		else {
+			Platform::debugOutput(L"Failed to create a window\n");
+		}
+	}
 
+	void Game::pumpMessages() {
+		MSG message;
+		while (PeekMessage(&message, 0, 0, 0, PM_REMOVE)) {
+			if (message.message == WM_QUIT)
+				running = false;
 
-			while (running) {
-				auto currentTime = std::chrono::high_resolution_clock::now();
-				deltaTime = currentTime - lastFrameTime;
+			TranslateMessage(&message);
+			DispatchMessage(&message); // sends message to WindowProc (WindowCallBack)
+		}
 
+		if (!Platform::pumpEvents())
+			running = false;
+	}
 
-				MSG message;
-				while (PeekMessage(&message, 0, 0, 0, PM_REMOVE)) {
-					if (message.message == WM_QUIT)
-						running = false;
+	void Game::presentFrame() {
+		HDC deviceContext = GetDC(windowHandle);
 
-					TranslateMessage(&message);
-					DispatchMessage(&message); // sends message to WindowProc (WindowCallBack)
-				}
+		int width, height;
+		Renderer::getWindowDimensions(&width, &height);
 
-				// update & render
+		Renderer::presentFrame(deviceContext, width, height);
 
-				Renderer::clear();
+		ReleaseDC(windowHandle, deviceContext);
+	}
+#else
+	// no window: the renderer's buffer is the surface and input comes from
+	// Platform::injectKey
+	void Game::startWindow() {
+		Renderer::resizeFrameBuffer(windowWidth, windowHeight);
 
-				getInstance().update(deltaTime.count());
+		if (!Renderer::getInstance().buffer.memory)
+			return;
 
-				HDC deviceContext = GetDC(windowHandle);
+		Platform::debugOutput(L"GAME INIT\n");
+		running = true;
 
-				int width, height;
-				Renderer::getWindowDimensions(&width, &height);
+		runLoop();
+	}
+
+	void Game::pumpMessages() {
+		if (!Platform::pumpEvents())
+			running = false;
+	}
+
+	void Game::presentFrame() {
+		int width, height;
+		Renderer::getWindowDimensions(&width, &height);
+
+		Renderer::presentFrame(width, height);
+	}
+#endif
+
+	void Game::runLoop() {
+		if (pipelineDepth > 1 && render)
+			runPipelinedLoop();
+		else
+			runSerialLoop();
+	}
+
+	// update, render and present one after another on the window thread
+	void Game::runSerialLoop() {
+		// init the clock
+		auto lastFrameTime = Platform::Clock::now();
+
+		frameSlot = 0;
+
+		while (running) {
+			auto currentTime = Platform::Clock::now();
+			deltaTime = currentTime - lastFrameTime;
+
+			pumpMessages();
+			if (!running)
+				break;
+
+			// update & render
+
+			Renderer::clear();
+
+			update(deltaTime.count());
 
-				Renderer::copyBufferToWindow(deviceContext, width, height);
+			if (render)
+				render(0);
 
-				lastFrameTime = currentTime;
+			presentFrame();
 
-				ReleaseDC(windowHandle, deviceContext);
+			lastFrameTime = currentTime;
+		}
+	}
+
+	// the window thread pumps messages and simulates frame N + 1 into its slot
+	// while the render thread draws and presents frame N from another slot
+	void Game::runPipelinedLoop() {
+		simulatedFrames = 0;
+		presentedFrames = 0;
+		pipelineStopping = false;
+
+		std::thread renderThread(&Game::renderLoop, this);
+
+		auto lastFrameTime = Platform::Clock::now();
+
+		while (running) {
+			auto currentTime = Platform::Clock::now();
+			deltaTime = currentTime - lastFrameTime;
+
+			pumpMessages();
+			if (!running)
+				break;
+
+			{
+				// the slot is free once the frame that last used it was presented,
+				// which bounds how far simulation runs ahead of the screen
+				std::unique_lock<std::mutex> lock(pipelineMutex);
+				pipelineCondition.wait(lock, [&] { return simulatedFrames - presentedFrames < (uint64_t)pipelineDepth; });
+				frameSlot = (int)(simulatedFrames % pipelineDepth);
 			}
 
+			update(deltaTime.count());
+
+			{
+				std::lock_guard<std::mutex> lock(pipelineMutex);
+				++simulatedFrames;
+			}
+			pipelineCondition.notify_all();
+
+			lastFrameTime = currentTime;
 		}
-		else {
-			OutputDebugString(L"Failed to create a window\n");
+
+		{
+			std::lock_guard<std::mutex> lock(pipelineMutex);
+			pipelineStopping = true;
+		}
+		pipelineCondition.notify_all();
+		renderThread.join();
+	}
+
+	void Game::renderLoop() {
+		for (;;) {
+			int slot;
+			{
+				std::unique_lock<std::mutex> lock(pipelineMutex);
+				pipelineCondition.wait(lock, [&] { return pipelineStopping || presentedFrames < simulatedFrames; });
+				if (pipelineStopping)
+					return;
+				slot = (int)(presentedFrames % pipelineDepth);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(Renderer::getInstance().bufferMutex);
+
+				Renderer::clear();
+
+				render(slot);
+
+				presentFrame();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(pipelineMutex);
+				++presentedFrames;
+			}
+			pipelineCondition.notify_all();
 		}
 	}
 }
\ No newline at end of file
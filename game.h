@@ -1,28 +1,45 @@
 #pragma once
 
-#include <windows.h>
+#include "platform.h"
 #include <string>
 #include <functional>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace frame {
 	class Game {
+#if defined(FRAME_PLATFORM_WIN32)
 		friend LRESULT CALLBACK WindowCallBack(
 			HWND windowHandle,
 			UINT message,
 			WPARAM wParam,
 			LPARAM lParam
 		);
+#endif
 
 	private:
+#if defined(FRAME_PLATFORM_WIN32)
 		HINSTANCE hInstance;
 		HWND windowHandle = 0;
+#endif
 		bool running = false;
 
 		std::wstring windowTitle;
 		int windowWidth, windowHeight;
 
 		std::function<void(float delta)> update;
+		std::function<void(int frameSlot)> render;
+
+		// pipelined frame loop, see setPipelineDepth
+		int pipelineDepth = 1;
+		int frameSlot = 0;
+		uint64_t simulatedFrames = 0;
+		uint64_t presentedFrames = 0;
+		bool pipelineStopping = false;
+		std::mutex pipelineMutex;
+		std::condition_variable pipelineCondition;
 
 	public:
 		Game();
@@ -49,6 +66,21 @@ namespace frame {
 
 		inline static void setGameUpdate(const std::function<void(float delta)>& update) { getInstance().update = update; }
 
+		// draws the frame stored in frameSlot; with a render callback set, update
+		// only simulates and writes what render needs into the getFrameSlot() slot
+		inline static void setGameRender(const std::function<void(int frameSlot)>& render) { getInstance().render = render; }
+
+		// frames in flight: 1 runs update and render back to back on the window thread,
+		// 2 (double buffered) or 3 (triple buffered) render and present on their own
+		// thread while update simulates the next frame, so a frame costs the larger of
+		// the two instead of their sum. The presented frame trails the simulated one by
+		// at most depth - 1 frames. Needs a render callback, read when the game starts
+		inline static void setPipelineDepth(int depth) { getInstance().pipelineDepth = depth < 1 ? 1 : (depth > 3 ? 3 : depth); }
+		inline static int getPipelineDepth() { return getInstance().pipelineDepth; }
+
+		// frame data slot the running update writes, 0 .. pipeline depth - 1
+		inline static int getFrameSlot() { return getInstance().frameSlot; }
+
 		inline static std::wstring getWindowTitle() { return getInstance().windowTitle; }
 		inline static int getWindowWidth() { return getInstance().windowWidth; }
 		inline static int getWindowHeight() { return getInstance().windowHeight; }
@@ -56,6 +88,20 @@ namespace frame {
 		std::chrono::duration<double> deltaTime;
 
 	private:
+		// opens the window (Win32) or the headless surface and runs the frame loop
+		// until it closes
 		void startWindow();
+
+		void runLoop();
+
+		void pumpMessages();
+
+		void presentFrame();
+
+		void runSerialLoop();
+
+		void runPipelinedLoop();
+
+		void renderLoop();
 	};
 }
\ No newline at end of file
@@ -22,99 +22,46 @@ namespace frame {
 		return ((!keyboard.keys[keycode].wasDown) && (keyboard.keys[keycode].isDown));
 	}
 
+	void Input::setKeyState(uint32_t keycode, bool wasDown, bool isDown) {
+		keyboard.keys[keycode].isDown = isDown;
+		keyboard.keys[keycode].wasDown = wasDown;
+	}
+
+#if defined(FRAME_PLATFORM_WIN32)
+	// F_ keycode of a virtual key, F_MAX_KEYS for keys frame does not track
+	static uint32_t toFrameKeycode(uint32_t VKCode) {
+		if (VKCode >= 'A' && VKCode <= 'Z')
+			return VKCode - 'A';
+		if (VKCode >= '0' && VKCode <= '9')
+			return VKCode - '0' + F_0;
+
+		switch (VKCode) {
+			case VK_UP: return F_UP;
+			case VK_DOWN: return F_DOWN;
+			case VK_LEFT: return F_LEFT;
+			case VK_RIGHT: return F_RIGHT;
+			case VK_OEM_MINUS: return F_MINUS;
+			case VK_OEM_PLUS: return F_PLUS;
+			case VK_SHIFT: return F_SHIFT;
+			case VK_CONTROL: return F_CONTROL;
+			case VK_MENU: return F_ALT;
+			case VK_SPACE: return F_SPACE;
+			case VK_ESCAPE: return F_ESCAPE;
+			case VK_CAPITAL: return F_CAPSLOCK;
+			case VK_TAB: return F_TAB;
+			case VK_RETURN: return F_ENTER;
+			case VK_BACK: return F_BACKSPACE;
+			case VK_OEM_3: return F_TILDE;
+			default: return F_MAX_KEYS;
+		}
+	}
+
 	void Input::processKeyboardInput(uint32_t VKCode, bool wasDown, bool isDown) {
 		if (wasDown != isDown) {
-			if (VKCode >= 'A' && VKCode <= 'Z') {
-				uint32_t frameKeycode = VKCode - 'A';
-				keyboard.keys[frameKeycode].isDown = isDown;
-				keyboard.keys[frameKeycode].wasDown = wasDown;
-			}
-			else if (VKCode == VK_UP)
-			{
-				keyboard.keys[F_UP].isDown = isDown;
-				keyboard.keys[F_UP].wasDown = wasDown;
-			}
-			else if (VKCode == VK_DOWN)
-			{
-				keyboard.keys[F_DOWN].isDown = isDown;
-				keyboard.keys[F_DOWN].wasDown = wasDown;
-			}
-			else if (VKCode == VK_LEFT)
-			{
-				keyboard.keys[F_LEFT].isDown = isDown;
-				keyboard.keys[F_LEFT].wasDown = wasDown;
-			}
-			else if (VKCode == VK_RIGHT)
-			{
-				keyboard.keys[F_RIGHT].isDown = isDown;
-				keyboard.keys[F_RIGHT].wasDown = wasDown;
-			}
-			else if (VKCode >= '0' && VKCode <= '9')
-			{
-				uint32_t F_keycode = VKCode - '0' + F_0;
-				keyboard.keys[F_keycode].isDown = isDown;
-				keyboard.keys[F_keycode].wasDown = wasDown;
-			}
-			else if (VKCode == VK_OEM_MINUS)
-			{
-				keyboard.keys[F_MINUS].isDown = isDown;
-				keyboard.keys[F_MINUS].wasDown = wasDown;
-			}
-			else if (VKCode == VK_OEM_PLUS)
-			{
-				keyboard.keys[F_PLUS].isDown = isDown;
-				keyboard.keys[F_PLUS].wasDown = wasDown;
-			}
-			else if (VKCode == VK_SHIFT)
-			{
-				keyboard.keys[F_SHIFT].isDown = isDown;
-				keyboard.keys[F_SHIFT].wasDown = wasDown;
-			}
-			else if (VKCode == VK_CONTROL)
-			{
-				keyboard.keys[F_CONTROL].isDown = isDown;
-				keyboard.keys[F_CONTROL].wasDown = wasDown;
-			}
-			else if (VKCode == VK_MENU)
-			{
-				keyboard.keys[F_ALT].isDown = isDown;
-				keyboard.keys[F_ALT].wasDown = wasDown;
-			}
-			else if (VKCode == VK_SPACE)
-			{
-				keyboard.keys[F_SPACE].isDown = isDown;
-				keyboard.keys[F_SPACE].wasDown = wasDown;
-			}
-			else if (VKCode == VK_ESCAPE)
-			{
-				keyboard.keys[F_ESCAPE].isDown = isDown;
-				keyboard.keys[F_ESCAPE].wasDown = wasDown;
-			}
-			else if (VKCode == VK_CAPITAL)
-			{
-				keyboard.keys[F_CAPSLOCK].isDown = isDown;
-				keyboard.keys[F_CAPSLOCK].wasDown = wasDown;
-			}
-			else if (VKCode == VK_TAB)
-			{
-				keyboard.keys[F_TAB].isDown = isDown;
-				keyboard.keys[F_TAB].wasDown = wasDown;
-			}
-			else if (VKCode == VK_RETURN)
-			{
-				keyboard.keys[F_ENTER].isDown = isDown;
-				keyboard.keys[F_ENTER].wasDown = wasDown;
-			}
-			else if (VKCode == VK_BACK)
-			{
-				keyboard.keys[F_BACKSPACE].isDown = isDown;
-				keyboard.keys[F_BACKSPACE].wasDown = wasDown;
-			}
-			else if (VKCode == VK_OEM_3)
-			{
-				keyboard.keys[F_TILDE].isDown = isDown;
-				keyboard.keys[F_TILDE].wasDown = wasDown;
-			}
+			uint32_t frameKeycode = toFrameKeycode(VKCode);
+			if (frameKeycode < F_MAX_KEYS)
+				setKeyState(frameKeycode, wasDown, isDown);
 		}
 	}
+#endif
 }
\ No newline at end of file
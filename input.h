@@ -1,6 +1,6 @@
 #pragma once
 
-#include <windows.h>
+#include "platform.h"
 #include <stdint.h>
 
 #define F_MAX_KEYS 52
@@ -63,15 +63,23 @@
 
 namespace frame {
 	class Input {
+#if defined(FRAME_PLATFORM_WIN32)
 		friend LRESULT CALLBACK WindowCallBack(
 			HWND windowHandle,
 			UINT message,
 			WPARAM wParam,
 			LPARAM lParam
 		);
+#endif
+
+		friend class Platform;
 
 		private:
+#if defined(FRAME_PLATFORM_WIN32)
 			static void processKeyboardInput(uint32_t VKCode, bool wasDown, bool isDown);
+#endif
+
+			static void setKeyState(uint32_t keycode, bool wasDown, bool isDown);
 
 		public:
 			struct KeyState {
@@ -16,22 +16,43 @@ frame_app_entry_point{
 	 player.inputMappings = map;
 	 //End Player Definition
 
+	// player position and stats line per frame slot, written by update and drawn by render
+	frame::vector2 playerFrames[3];
+	frame::TextBuffer<64> statsFrames[3];
+
 	frame::Game::setGameUpdate([&](float delta) {
-		wchar_t charBuffer[256];
-		swprintf(charBuffer, 256, L"delta: %f\n", frame::Game::getInstance().deltaTime.count());
-		OutputDebugString(charBuffer);
+		int slot = frame::Game::getFrameSlot();
+
+		frame::TextBuffer<64>& stats = statsFrames[slot];
+		stats.clear();
+		stats.append("fps ").append(delta > 0 ? 1.0 / delta : 0.0, 1).append("  frame ").append(delta * 1000.0, 2).append(" ms");
+
+		playerFrames[slot] = player.position;
+	}
+	);
+
+	// recorded and drawn by render
+	frame::DrawList drawList;
 
-		
+	frame::Game::setGameRender([&](int frameSlot) {
+		const frame::vector2& position = playerFrames[frameSlot];
+		frame::DrawList::Recorder& recorder = drawList.getRecorder();
 
-		if((player.position.x >= -32) && (player.position.x < 32)){
-			if ((player.position.y > -18) && (player.position.y < 18)) {
-				frame::Renderer::FillRectangle({(int)((player.position.x + 64) * 10), (int)((player.position.y + 36) * 10), 20, 20}, {200, 0, 0});
+		if((position.x >= -32) && (position.x < 32)){
+			if ((position.y > -18) && (position.y < 18)) {
+				recorder.fillRectangle({(int)((position.x + 64) * 10), (int)((position.y + 36) * 10), 20, 20}, {200, 0, 0});
 			}
 		}
 
+		recorder.drawString(frame::Font::builtIn(2), statsFrames[frameSlot].c_str(), 8, 8, {255, 255, 255}, 1);
+
+		drawList.submit();
 	}
 	);
 
+	// simulate the next frame while the previous one is drawn
+	frame::Game::setPipelineDepth(2);
+
 	frame::Renderer::SetClearColor({200, 100, 0});
 
 	frame::Game::start();
@@ -0,0 +1,371 @@
+// mesh_io.h
+#ifndef MESH_IO_H
+#define MESH_IO_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "render_system.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary mesh file: a fixed header followed by the IndexedMesh streams,
+// each starting on a meshFileAlignment boundary so a mapped file can be
+// read in place with aligned vector loads. Values are stored in native
+// (little-endian) byte order.
+static const char meshFileMagic[4] = { 'R', 'S', 'M', 'F' };
+static const uint32_t meshFileVersion = 1;
+static const size_t meshFileAlignment = 64;
+
+enum MeshFileStream {
+    MeshStreamPositionX, MeshStreamPositionY, MeshStreamPositionZ,
+    MeshStreamColors,
+    MeshStreamTexU, MeshStreamTexV,
+    MeshStreamNormalX, MeshStreamNormalY, MeshStreamNormalZ,
+    MeshStreamIndices,
+    MeshStreamCount
+};
+
+struct MeshFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    uint32_t wideIndices;
+    uint32_t reserved;
+    float boundsMin[3], boundsMax[3];
+    float sphereCenter[3], sphereRadius;
+    uint64_t streamOffsets[MeshStreamCount];
+};
+
+// Byte size of a stream for the given counts
+inline size_t meshFileStreamSize(int stream, size_t vertexCount, size_t triangleCount, bool wideIndices) {
+    if (stream == MeshStreamIndices) return triangleCount * 3 * (wideIndices ? sizeof(uint32_t) : sizeof(uint16_t));
+    if (stream == MeshStreamColors) return vertexCount * sizeof(Color);
+    return vertexCount * sizeof(float);
+}
+
+// Writes the mesh, its bounds included, in the binary mesh format
+inline bool saveMeshFile(const std::string& path, const IndexedMesh& mesh) {
+    IndexedMeshView view = mesh.getView();
+    bool wide = view.indices32 != nullptr;
+    const void* streams[MeshStreamCount] = {
+        view.positionX, view.positionY, view.positionZ, view.colors, view.texU, view.texV,
+        view.normalX, view.normalY, view.normalZ,
+        wide ? (const void*)view.indices32 : (const void*)view.indices16
+    };
+    
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, meshFileMagic, sizeof(header.magic));
+    header.version = meshFileVersion;
+    header.vertexCount = (uint32_t)view.vertexCount;
+    header.triangleCount = (uint32_t)view.triangleCount;
+    header.wideIndices = wide ? 1 : 0;
+    const vector3 bounds[3] = { view.bounds.min, view.bounds.max, view.sphere.center };
+    for (int i = 0; i < 3; ++i) {
+        float* out = i == 0 ? header.boundsMin : (i == 1 ? header.boundsMax : header.sphereCenter);
+        out[0] = bounds[i].x;
+        out[1] = bounds[i].y;
+        out[2] = bounds[i].z;
+    }
+    header.sphereRadius = view.sphere.radius;
+    
+    uint64_t offset = sizeof(header);
+    for (int stream = 0; stream < MeshStreamCount; ++stream) {
+        offset = (offset + meshFileAlignment - 1) & ~(uint64_t)(meshFileAlignment - 1);
+        header.streamOffsets[stream] = offset;
+        offset += meshFileStreamSize(stream, view.vertexCount, view.triangleCount, wide);
+    }
+    
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t written = sizeof(header);
+    static const char padding[meshFileAlignment] = {};
+    for (int stream = 0; stream < MeshStreamCount && ok; ++stream) {
+        size_t gap = (size_t)(header.streamOffsets[stream] - written);
+        size_t size = meshFileStreamSize(stream, view.vertexCount, view.triangleCount, wide);
+        ok = fwrite(padding, 1, gap, file) == gap && (size == 0 || fwrite(streams[stream], 1, size, file) == size);
+        written += gap + size;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+// Read-only memory mapping of a binary mesh file. Opening validates the
+// header and the stream extents and makes one pass over the indices to
+// check that each names a vertex; the geometry is then used in place
+// through getView(), with no per-vertex parsing or copying.
+class MappedMesh {
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+    IndexedMeshView view;
+    
+    bool mapFile(const std::string& path) {
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return false;
+        size = (size_t)fileSize.QuadPart;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return false;
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        return data != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        data = static_cast<const uint8_t*>(mapped);
+        return true;
+#endif
+    }
+    
+    template <typename T>
+    const T* stream(const MeshFileHeader& header, int index) const {
+        return reinterpret_cast<const T*>(data + header.streamOffsets[index]);
+    }
+    
+    // Largest of count indices; a running maximum the compiler can vectorize,
+    // leaving a single range compare
+    template <typename T>
+    static uint32_t largestIndex(const T* indices, size_t count) {
+        uint32_t largest = 0;
+        for (size_t i = 0; i < count; ++i) largest = std::max(largest, (uint32_t)indices[i]);
+        return largest;
+    }
+
+public:
+    MappedMesh() = default;
+    MappedMesh(const MappedMesh&) = delete;
+    MappedMesh& operator=(const MappedMesh&) = delete;
+    
+    ~MappedMesh() { close(); }
+    
+    bool open(const std::string& path) {
+        close();
+        if (!mapFile(path) || size < sizeof(MeshFileHeader)) {
+            close();
+            return false;
+        }
+        
+        MeshFileHeader header;
+        memcpy(&header, data, sizeof(header));
+        bool valid = memcmp(header.magic, meshFileMagic, sizeof(header.magic)) == 0 && header.version == meshFileVersion;
+        // counts whose streams would not fit a size_t are corrupt
+        size_t indexSize = header.wideIndices ? sizeof(uint32_t) : sizeof(uint16_t);
+        valid = valid && header.vertexCount <= SIZE_MAX / std::max(sizeof(float), sizeof(Color)) &&
+                header.triangleCount <= SIZE_MAX / 3 / indexSize;
+        for (int i = 0; i < MeshStreamCount && valid; ++i) {
+            uint64_t offset = header.streamOffsets[i];
+            uint64_t streamSize = meshFileStreamSize(i, header.vertexCount, header.triangleCount, header.wideIndices != 0);
+            valid = offset % meshFileAlignment == 0 && offset <= size && streamSize <= size - offset;
+        }
+        // The view is drawn in place, so an index past the vertex streams (a
+        // truncated, stale or corrupt file) would make the renderer read out
+        // of bounds
+        size_t indexCount = (size_t)header.triangleCount * 3;
+        if (valid && indexCount > 0) {
+            uint32_t largest = header.wideIndices
+                ? largestIndex(stream<uint32_t>(header, MeshStreamIndices), indexCount)
+                : largestIndex(stream<uint16_t>(header, MeshStreamIndices), indexCount);
+            valid = largest < header.vertexCount;
+        }
+        if (!valid) {
+            close();
+            return false;
+        }
+        
+        view = IndexedMeshView();
+        view.positionX = stream<float>(header, MeshStreamPositionX);
+        view.positionY = stream<float>(header, MeshStreamPositionY);
+        view.positionZ = stream<float>(header, MeshStreamPositionZ);
+        view.colors = stream<Color>(header, MeshStreamColors);
+        view.texU = stream<float>(header, MeshStreamTexU);
+        view.texV = stream<float>(header, MeshStreamTexV);
+        view.normalX = stream<float>(header, MeshStreamNormalX);
+        view.normalY = stream<float>(header, MeshStreamNormalY);
+        view.normalZ = stream<float>(header, MeshStreamNormalZ);
+        if (header.wideIndices) view.indices32 = stream<uint32_t>(header, MeshStreamIndices);
+        else view.indices16 = stream<uint16_t>(header, MeshStreamIndices);
+        view.vertexCount = header.vertexCount;
+        view.triangleCount = header.triangleCount;
+        view.bounds = BoundingBox(vector3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+                                  vector3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+        view.sphere = BoundingSphere(vector3(header.sphereCenter[0], header.sphereCenter[1], header.sphereCenter[2]), header.sphereRadius);
+        return true;
+    }
+    
+    void close() {
+#if defined(_WIN32)
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+        view = IndexedMeshView();
+    }
+    
+    bool isOpen() const { return data != nullptr; }
+    
+    // Valid until the mesh is closed
+    const IndexedMeshView& getView() const { return view; }
+};
+
+// Wavefront OBJ importer. Reads v (with optional r g b vertex colors in
+// 0..1), vt and vn records and f records of any size, which are fanned into
+// triangles; negative indices count back from the latest record. Corners
+// that share position, texture coordinate and normal indices are welded.
+// Vertices without a color take defaultColor. Other records are ignored.
+// Returns false on a v, vt or vn record that is short or has anything but
+// numbers on its line.
+inline bool loadObj(const std::string& path, IndexedMesh& mesh, const Color& defaultColor = Color()) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::string text;
+    char chunk[65536];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) text.append(chunk, read);
+    fclose(file);
+    
+    std::vector<vector3> positions, normals;
+    std::vector<Color> positionColors;
+    std::vector<float> texCoords;
+    std::unordered_map<std::string, uint32_t> cornerLookup;
+    std::vector<uint32_t> polygon;
+    mesh = IndexedMesh(defaultColor);
+    
+    auto toColor = [](float value) { return (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+    
+    // Reads up to maxCount numbers from p without passing lineEnd; -1 when
+    // anything but whitespace follows them on the line
+    auto readFloats = [](const char* p, const char* lineEnd, float* out, int maxCount) {
+        int count = 0;
+        char* next;
+        for (; count < maxCount; ++count) {
+            float value = strtof(p, &next);
+            if (next == p || next > lineEnd) break;
+            out[count] = value;
+            p = next;
+        }
+        while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        return p == lineEnd ? count : -1;
+    };
+    
+    // Resolves a 1-based or negative index against count records; 0 when invalid
+    auto resolve = [](long index, size_t count) -> size_t {
+        if (index < 0) index += (long)count + 1;
+        return index >= 1 && (size_t)index <= count ? (size_t)index : 0;
+    };
+    
+    const char* cursor = text.c_str();
+    const char* end = cursor + text.size();
+    while (cursor < end) {
+        const char* lineEnd = (const char*)memchr(cursor, '\n', end - cursor);
+        if (!lineEnd) lineEnd = end;
+        while (cursor < lineEnd && (*cursor == ' ' || *cursor == '\t')) ++cursor;
+        
+        char* next;
+        if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            float values[6];
+            int count = 0;
+            const char* p = cursor + 2;
+            for (; count < 6; ++count) {
+                values[count] = strtof(p, &next);
+                if (next == p || next > lineEnd) break;
+                p = next;
+            }
+            if (count < 3) return false;
+            positions.push_back(vector3(values[0], values[1], values[2]));
+            positionColors.push_back(count == 6 ? Color(toColor(values[3]), toColor(values[4]), toColor(values[5])) : defaultColor);
+        }
+        else if (cursor[0] == 'v' && cursor[1] == 't') {
+            // u, then optional v (0 when left out) and an ignored w
+            float uvw[3] = { 0.0f, 0.0f, 0.0f };
+            if (readFloats(cursor + 2, lineEnd, uvw, 3) < 1) return false;
+            texCoords.push_back(uvw[0]);
+            texCoords.push_back(uvw[1]);
+        }
+        else if (cursor[0] == 'v' && cursor[1] == 'n') {
+            float n[3];
+            if (readFloats(cursor + 2, lineEnd, n, 3) != 3) return false;
+            normals.push_back(vector3(n[0], n[1], n[2]));
+        }
+        else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            polygon.clear();
+            const char* p = cursor + 2;
+            for (;;) {
+                while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+                if (p >= lineEnd) break;
+                
+                long corner[3] = { 0, 0, 0 };
+                for (int field = 0; field < 3; ++field) {
+                    if (*p != '/') {
+                        corner[field] = strtol(p, &next, 10);
+                        if (next == p) return false;
+                        p = next;
+                    }
+                    if (*p != '/') break;
+                    ++p;
+                }
+                
+                size_t position = resolve(corner[0], positions.size());
+                size_t texCoord = corner[1] ? resolve(corner[1], texCoords.size() / 2) : 0;
+                size_t normal = corner[2] ? resolve(corner[2], normals.size()) : 0;
+                if (!position || (corner[1] && !texCoord) || (corner[2] && !normal)) return false;
+                
+                const uint32_t key[3] = { (uint32_t)position, (uint32_t)texCoord, (uint32_t)normal };
+                auto found = cornerLookup.emplace(std::string(reinterpret_cast<const char*>(key), sizeof(key)), 0);
+                if (found.second) {
+                    Vertex v(positions[position - 1], positionColors[position - 1]);
+                    if (texCoord) {
+                        v.u = texCoords[(texCoord - 1) * 2];
+                        v.v = texCoords[(texCoord - 1) * 2 + 1];
+                    }
+                    if (normal) v.normal = normals[normal - 1];
+                    found.first->second = mesh.addVertex(v);
+                }
+                polygon.push_back(found.first->second);
+            }
+            
+            for (size_t i = 1; i + 1 < polygon.size(); ++i) mesh.addTriangle(polygon[0], polygon[i], polygon[i + 1]);
+        }
+        cursor = lineEnd + 1;
+    }
+    return true;
+}
+
+#endif
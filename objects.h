@@ -6,14 +6,15 @@
 #include <optional>
 #include <memory>
 #include <stdexcept>
-#include <windows.h>
+#include <string>
+#include <vector>
 
 #ifndef OBJECTS_H
 #define OBJECTS_H
 
 #ifndef INVENTORY_ON
 #define INVENTORY_ON true;
-#endif INVENTORY_ON
+#endif // INVENTORY_ON
 
 namespace frame {
 	class item {
@@ -47,6 +48,7 @@ namespace frame {
 
 		bool processObjInput(int keycode) {
 			this->inputMappings[keycode]();
+			return true;
 		};
 	};
 
@@ -61,4 +63,4 @@ namespace frame {
 	};
 }
 
-#endif OBJECTS_H
\ No newline at end of file
+#endif // OBJECTS_H
\ No newline at end of file
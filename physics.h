@@ -44,4 +44,4 @@ namespace frame {
 		a.linearVel += (acceleration * Game::getInstance().deltaTime.count());
 	}
 }
-#endif PHYSICS_H
\ No newline at end of file
+#endif // PHYSICS_H
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "platform.h"
+#include "input.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace frame {
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared surfaces need a lock free frame counter");
+
+	// pixels start on their own cache line after the header
+	static const uint32_t sharedPixelOffset = 64;
+
+	Platform::Platform() {
+		if (const char* frames = getenv("FRAME_HEADLESS_FRAMES"))
+			frameLimit = strtoull(frames, nullptr, 10);
+		if (const char* name = getenv("FRAME_HEADLESS_SHM"))
+			sharedName = name;
+	}
+
+	void Platform::debugOutput(const wchar_t* text) {
+#if defined(FRAME_PLATFORM_WIN32)
+		OutputDebugStringW(text);
+#else
+		fprintf(stderr, "%ls", text);
+#endif
+	}
+
+	void Platform::injectKey(uint32_t keycode, bool isDown) {
+		if (keycode >= F_MAX_KEYS)
+			return;
+
+		Platform& platform = getInstance();
+		std::lock_guard<std::mutex> lock(platform.eventMutex);
+		platform.keyEvents.push_back({ keycode, isDown });
+	}
+
+	void Platform::requestClose() {
+		Platform& platform = getInstance();
+		std::lock_guard<std::mutex> lock(platform.eventMutex);
+		platform.closeRequested = true;
+	}
+
+	bool Platform::pumpEvents() {
+		Platform& platform = getInstance();
+		std::lock_guard<std::mutex> lock(platform.eventMutex);
+
+		for (const KeyEvent& event : platform.keyEvents)
+			Input::setKeyState(event.keycode, Input::isKeyPressed(event.keycode), event.isDown);
+		platform.keyEvents.clear();
+
+		if (platform.closeRequested) {
+			platform.closeRequested = false;
+			return false;
+		}
+
+#if defined(FRAME_PLATFORM_HEADLESS)
+		if (platform.frameLimit && platform.pumpedFrames >= platform.frameLimit)
+			return false;
+		platform.pumpedFrames++;
+#endif
+		return true;
+	}
+
+	void* Platform::allocateFrameBuffer(int width, int height, int pitch) {
+		Platform& platform = getInstance();
+		bool shared = !platform.sharedName.empty();
+		size_t size = (size_t)pitch * height + (shared ? sharedPixelOffset : 0);
+		void* base = nullptr;
+
+#if defined(_WIN32)
+		if (shared) {
+			platform.mappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				(DWORD)((uint64_t)size >> 32), (DWORD)size, platform.sharedName.c_str());
+			if (platform.mappingHandle)
+				base = MapViewOfFile(platform.mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		}
+		else {
+			base = VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		}
+#else
+		if (shared) {
+			int fd = shm_open(platform.sharedName.c_str(), O_CREAT | O_RDWR, 0644);
+			if (fd >= 0) {
+				if (ftruncate(fd, (off_t)size) == 0) {
+					void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+					if (mapped != MAP_FAILED)
+						base = mapped;
+				}
+				close(fd);
+			}
+		}
+		else {
+			void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mapped != MAP_FAILED)
+				base = mapped;
+		}
+#endif
+
+		if (!base) {
+			debugOutput(L"Failed to allocate the frame buffer\n");
+			return nullptr;
+		}
+
+		platform.mappingBase = base;
+		platform.mappingSize = size;
+		platform.sharedMapping = shared;
+
+		if (!shared)
+			return base;
+
+		// an object reused from an earlier run may still hold its frames
+		memset(base, 0, size);
+
+		SharedSurfaceHeader* header = (SharedSurfaceHeader*)base;
+		memcpy(header->magic, "FRSF", 4);
+		header->width = width;
+		header->height = height;
+		header->pitch = pitch;
+		header->pixelOffset = sharedPixelOffset;
+		header->frameIndex.store(0, std::memory_order_release);
+
+		return (uint8_t*)base + sharedPixelOffset;
+	}
+
+	void Platform::freeFrameBuffer(void* memory) {
+		Platform& platform = getInstance();
+		if (!memory || !platform.mappingBase)
+			return;
+
+#if defined(_WIN32)
+		if (platform.sharedMapping) {
+			UnmapViewOfFile(platform.mappingBase);
+			CloseHandle(platform.mappingHandle);
+			platform.mappingHandle = nullptr;
+		}
+		else {
+			VirtualFree(platform.mappingBase, 0, MEM_RELEASE);
+		}
+#else
+		// the shared object keeps its name, readers may still have it mapped
+		munmap(platform.mappingBase, platform.mappingSize);
+#endif
+
+		platform.mappingBase = nullptr;
+		platform.mappingSize = 0;
+		platform.sharedMapping = false;
+		platform.surface.memory = nullptr;
+	}
+
+	void Platform::presentSurface(const void* memory, int width, int height, int pitch, PixelFormat format, const std::vector<Rect>& changedRects, bool fullFrame) {
+		Platform& platform = getInstance();
+		HeadlessSurface& surface = platform.surface;
+
+		surface.memory = memory;
+		surface.width = width;
+		surface.height = height;
+		surface.pitch = pitch;
+		surface.format = format;
+		surface.frameIndex++;
+		surface.fullFrame = fullFrame;
+		if (fullFrame)
+			surface.changedRects.clear();
+		else
+			surface.changedRects = changedRects;
+
+		if (platform.sharedMapping && memory == (uint8_t*)platform.mappingBase + sharedPixelOffset)
+			((SharedSurfaceHeader*)platform.mappingBase)->frameIndex.store(surface.frameIndex, std::memory_order_release);
+
+		if (platform.presentCallback)
+			platform.presentCallback(surface);
+	}
+}
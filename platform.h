@@ -0,0 +1,152 @@
+#pragma once
+
+// Picks the backend Game, Renderer and Input run on. Windows builds open a
+// Win32 window unless FRAME_HEADLESS is defined; every other build runs
+// headless: no window, frames are presented to the renderer's own buffer
+// (optionally placed in shared memory for another process to read) and
+// input is injected through Platform::injectKey.
+//
+// Headless build of the demo:
+//   g++ -std=c++17 -O2 -pthread main.cpp game.cpp renderer.cpp input.cpp platform.cpp text.cpp draw_list.cpp vectors.cpp -o frame_headless
+//
+// Environment read by the headless backend at startup:
+//   FRAME_HEADLESS_FRAMES   frames to run before closing (default: until Platform::requestClose)
+//   FRAME_HEADLESS_SHM      shared memory object holding the frame buffer, e.g. /frame_surface
+#if defined(_WIN32) && !defined(FRAME_HEADLESS)
+#define FRAME_PLATFORM_WIN32
+#else
+#define FRAME_PLATFORM_HEADLESS
+#endif
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace frame {
+
+	struct Rect {
+		int x, y, width, height;
+	};
+
+	// channel order of 32-bit frame buffer pixels
+	enum class PixelFormat {
+		BGRX,	// 0xXXRRGGBB, the window's native order
+		RGBA	// 0xAABBGGRR, RenderSystem's Color in memory
+	};
+
+	// the headless backend's window: the renderer's buffer itself, so a present
+	// is a frame count and a list of changed rectangles rather than a copy
+	struct HeadlessSurface {
+		const void* memory = nullptr;	// 32-bit pixels, top row first
+		int width = 0, height = 0;
+		int pitch = 0;					// in bytes
+		PixelFormat format = PixelFormat::BGRX;
+		uint64_t frameIndex = 0;		// presents so far
+		std::vector<Rect> changedRects;	// changed by the last present, unless fullFrame
+		bool fullFrame = true;
+	};
+
+	// first bytes of a shared surface object; the pixels start at pixelOffset.
+	// frameIndex is stored with release order after the frame is complete
+	struct SharedSurfaceHeader {
+		char magic[4];					// "FRSF"
+		int32_t width, height, pitch;
+		uint32_t pixelOffset;
+		std::atomic<uint64_t> frameIndex;
+	};
+
+	class Platform {
+		friend class Renderer;
+		friend class Game;
+
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		// to the debugger on Win32, to stderr headless
+		static void debugOutput(const wchar_t* text);
+
+		// queues a key change (F_ keycode), applied by the next message pump of the
+		// game loop like a window key event. safe from any thread
+		static void injectKey(uint32_t keycode, bool isDown);
+
+		// queues a close, the game loop stops at its next message pump
+		static void requestClose();
+
+		// headless: frames to run before the loop closes by itself, 0 for no limit
+		inline static void setFrameLimit(uint64_t frames) { getInstance().frameLimit = frames; }
+
+		// places the frame buffer in the named shared memory object (POSIX shm_open
+		// name, or a Win32 file mapping name), behind a SharedSurfaceHeader.
+		// takes effect on the next buffer resize, so set it before Game::start.
+		// a buffer bound with Renderer::SetExternalBuffer is not shared
+		inline static void setSharedSurface(const std::string& name) { getInstance().sharedName = name; }
+
+		// headless: called on the presenting thread after every present; the
+		// surface memory stays valid and unchanged until the callback returns
+		inline static void setPresentCallback(const std::function<void(const HeadlessSurface&)>& callback) { getInstance().presentCallback = callback; }
+
+		// headless: the last present. read it from the present callback or once
+		// the game loop has returned
+		inline static const HeadlessSurface& getSurface() { return getInstance().surface; }
+
+	private:
+		Platform();
+
+		Platform(const Platform&) = delete;
+		Platform& operator= (const Platform&) = delete;
+
+		~Platform() {}
+
+		inline static Platform& getInstance() {
+			static Platform platform;
+			return platform;
+		}
+
+		struct KeyEvent {
+			uint32_t keycode;
+			bool isDown;
+		};
+
+		std::mutex eventMutex;
+		std::vector<KeyEvent> keyEvents;
+		bool closeRequested = false;
+
+		uint64_t frameLimit = 0;
+		uint64_t pumpedFrames = 0;
+
+		std::string sharedName;
+		void* mappingBase = nullptr;
+		size_t mappingSize = 0;
+		bool sharedMapping = false;
+#if defined(_WIN32)
+		HANDLE mappingHandle = nullptr;
+#endif
+
+		HeadlessSurface surface;
+		std::function<void(const HeadlessSurface&)> presentCallback;
+
+	private:
+		// applies the queued key changes to Input; false once the loop should close
+		static bool pumpEvents();
+
+		// zeroed, page aligned memory for a frame buffer of height rows of pitch bytes
+		static void* allocateFrameBuffer(int width, int height, int pitch);
+
+		static void freeFrameBuffer(void* memory);
+
+		// records a present of the buffer, see HeadlessSurface
+		static void presentSurface(const void* memory, int width, int height, int pitch, PixelFormat format, const std::vector<Rect>& changedRects, bool fullFrame);
+	};
+}
@@ -0,0 +1,280 @@
+// render_benchmark.cpp
+// Headless throughput benchmark for RenderSystem. Renders synthetic scenes
+// into an off-screen FrameBuffer at several resolutions and prints one JSON
+// document to stdout, so results of two builds can be diffed directly.
+//
+// Build (no window or platform code involved):
+//   g++ -std=c++17 -O2 -mavx2 -pthread render_benchmark.cpp -o render_benchmark
+//   cl /std:c++17 /O2 /arch:AVX2 /EHsc render_benchmark.cpp
+//
+// Options:
+//   --objects N          cubes and pyramids in the objects scene (default 2000)
+//   --layers N           stacked screen-filling quads in the overdraw scene (default 16)
+//   --frames N           measured frames per run, after two warm-up frames (default 20)
+//   --resolutions LIST   comma-separated WxH list (default 640x360,1280x720,1920x1080)
+//   --scenes LIST        any of objects,ground,overdraw (default all three)
+//   --modes LIST         any of untiled,tiled,visibility,visibility-tiled (default untiled,tiled)
+//   --threads N          tiled mode workers, 0 for every hardware thread (default 0)
+//   --scalar             force the scalar rasterizer kernel
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "render_system.h"
+
+struct BenchmarkOptions {
+    int objects = 2000;
+    int layers = 16;
+    int frames = 20;
+    unsigned threads = 0;
+    bool scalar = false;
+    std::vector<std::pair<int, int>> resolutions = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 } };
+    std::vector<std::string> scenes = { "objects", "ground", "overdraw" };
+    std::vector<std::string> modes = { "untiled", "tiled" };
+};
+
+// Result of one scene, resolution and mode; per-frame values are averages
+struct BenchmarkResult {
+    std::string scene, mode;
+    int width = 0, height = 0, frames = 0;
+    double meanMs = 0, minMs = 0, maxMs = 0;
+    double submitted = 0, emitted = 0;
+    StageTimings stages; // seconds per frame
+};
+
+static std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* c = text; ; ++c) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) items.push_back(item);
+            item.clear();
+            if (*c == '\0') break;
+        }
+        else item += *c;
+    }
+    return items;
+}
+
+// Deterministic generator, so every build renders the same scene
+struct SceneRandom {
+    uint32_t state;
+    
+    explicit SceneRandom(uint32_t seed) : state(seed) {}
+    
+    float next(float low, float high) {
+        state = state * 1664525u + 1013904223u;
+        return low + (high - low) * ((state >> 8) * (1.0f / 16777216.0f));
+    }
+};
+
+// Cubes and pyramids from MeshGenerators scattered in front of the camera
+static std::vector<Mesh> buildObjectsScene(int count) {
+    std::vector<Mesh> meshes;
+    meshes.reserve(count);
+    SceneRandom random(12345);
+    for (int i = 0; i < count; ++i) {
+        Color color((uint8_t)random.next(64, 255), (uint8_t)random.next(64, 255), (uint8_t)random.next(64, 255));
+        Mesh mesh = (i % 2) ? MeshGenerators::createCube(random.next(0.5f, 1.5f), color)
+                            : MeshGenerators::createPyramid(random.next(0.5f, 1.5f), random.next(0.5f, 2.0f), color);
+        vector3 offset(random.next(-30, 30), random.next(-4, 4), random.next(2, 80));
+        for (auto& tri : mesh.triangles) {
+            tri.v0.position = tri.v0.position + offset;
+            tri.v1.position = tri.v1.position + offset;
+            tri.v2.position = tri.v2.position + offset;
+        }
+        mesh.markBoundsDirty();
+        meshes.push_back(mesh);
+    }
+    return meshes;
+}
+
+// Large subdivided ground plane below the camera, reaching behind it, so
+// most triangles are clipped against the near plane or the guard band
+static std::vector<Mesh> buildGroundScene() {
+    const int cells = 64;
+    const float extent = 200.0f, height = -2.0f;
+    Mesh ground(Color(60, 160, 60));
+    for (int z = 0; z < cells; ++z) {
+        for (int x = 0; x < cells; ++x) {
+            float x0 = -extent + 2.0f * extent * x / cells, x1 = -extent + 2.0f * extent * (x + 1) / cells;
+            float z0 = -extent + 2.0f * extent * z / cells, z1 = -extent + 2.0f * extent * (z + 1) / cells;
+            Color inner((uint8_t)(x * 4), 160, (uint8_t)(z * 4)), outer((uint8_t)(255 - x * 4), 120, 60);
+            Vertex a(vector3(x0, height, z0), inner), b(vector3(x1, height, z0), outer);
+            Vertex c(vector3(x1, height, z1), inner), d(vector3(x0, height, z1), outer);
+            ground.addTriangle(a, d, c);
+            ground.addTriangle(a, c, b);
+        }
+    }
+    return { ground };
+}
+
+// Screen-filling quads drawn back to front, so every layer passes the depth
+// test and each pixel is shaded once per layer
+static std::vector<Mesh> buildOverdrawScene(int layers) {
+    std::vector<Mesh> meshes;
+    for (int i = 0; i < layers; ++i) {
+        float z = 2.0f + (layers - i);
+        float halfWidth = z * 2.0f, halfHeight = z * 1.5f;
+        Color color((uint8_t)(40 + i * 200 / layers), 80, (uint8_t)(240 - i * 200 / layers));
+        Mesh quad(color);
+        Vertex a(vector3(-halfWidth, -halfHeight, z), color), b(vector3(halfWidth, -halfHeight, z), color);
+        Vertex c(vector3(halfWidth, halfHeight, z), color), d(vector3(-halfWidth, halfHeight, z), color);
+        quad.addTriangle(a, d, c);
+        quad.addTriangle(a, c, b);
+        meshes.push_back(quad);
+    }
+    return meshes;
+}
+
+static bool isKnownMode(const std::string& mode) {
+    return mode == "untiled" || mode == "tiled" || mode == "visibility" || mode == "visibility-tiled";
+}
+
+static BenchmarkResult runBenchmark(const std::string& scene, const std::vector<Mesh>& meshes, int width, int height,
+                                    const std::string& mode, const BenchmarkOptions& options) {
+    FrameBuffer frameBuffer(width, height);
+    Camera camera;
+    camera.setFrustum(90.0f, (float)width / height, 0.1f, 1000.0f);
+    RenderSystem renderer(frameBuffer, camera);
+    renderer.setCullMode(CullMode::None);
+    renderer.setSimdEnabled(!options.scalar);
+    if (mode == "tiled" || mode == "visibility-tiled") renderer.setTiledMode(true, 64, options.threads);
+    renderer.setVisibilityBufferEnabled(mode == "visibility" || mode == "visibility-tiled");
+    
+    BenchmarkResult result;
+    result.scene = scene;
+    result.mode = mode;
+    result.width = width;
+    result.height = height;
+    result.frames = options.frames;
+    result.minMs = 1e30;
+    
+    const int warmupFrames = 2;
+    for (int frame = 0; frame < warmupFrames + options.frames; ++frame) {
+        if (frame == warmupFrames) {
+            renderer.resetPrimitiveStats();
+            renderer.resetStageTimings();
+            renderer.setStageTimingEnabled(true);
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        frameBuffer.clear(Color(0, 0, 0, 255), FLT_MAX);
+        renderer.renderScene(meshes);
+        renderer.resolveVisibility();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        
+        if (frame < warmupFrames) continue;
+        result.meanMs += ms;
+        result.minMs = std::min(result.minMs, ms);
+        result.maxMs = std::max(result.maxMs, ms);
+    }
+    
+    double frames = options.frames;
+    const PrimitiveStats& stats = renderer.getPrimitiveStats();
+    const StageTimings& stages = renderer.getStageTimings();
+    result.meanMs /= frames;
+    result.submitted = stats.submitted / frames;
+    result.emitted = stats.emitted / frames;
+    result.stages.cull = stages.cull / frames;
+    result.stages.assembly = stages.assembly / frames;
+    result.stages.binning = stages.binning / frames;
+    result.stages.raster = stages.raster / frames;
+    result.stages.resolve = stages.resolve / frames;
+    return result;
+}
+
+static void printJson(const std::vector<BenchmarkResult>& results, const BenchmarkOptions& options) {
+    printf("{\n");
+    printf("  \"simdWidth\": %d,\n", options.scalar ? 1 : RS_SIMD_WIDTH);
+    printf("  \"threads\": %u,\n", options.threads);
+    printf("  \"framesPerRun\": %d,\n", options.frames);
+    printf("  \"runs\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        double seconds = r.meanMs / 1000.0;
+        printf("    {\n");
+        printf("      \"scene\": \"%s\", \"mode\": \"%s\", \"width\": %d, \"height\": %d,\n",
+               r.scene.c_str(), r.mode.c_str(), r.width, r.height);
+        printf("      \"msPerFrame\": { \"mean\": %.4f, \"min\": %.4f, \"max\": %.4f },\n", r.meanMs, r.minMs, r.maxMs);
+        printf("      \"trianglesSubmitted\": %.0f, \"trianglesEmitted\": %.0f,\n", r.submitted, r.emitted);
+        printf("      \"trianglesPerSec\": %.0f, \"pixelsPerSec\": %.0f, \"nsPerTriangle\": %.2f,\n",
+               r.submitted / seconds, (double)r.width * r.height / seconds, r.submitted > 0 ? r.meanMs * 1e6 / r.submitted : 0.0);
+        printf("      \"stageMs\": { \"cull\": %.4f, \"assembly\": %.4f, \"binning\": %.4f, \"raster\": %.4f, \"resolve\": %.4f }\n",
+               r.stages.cull * 1000.0, r.stages.assembly * 1000.0, r.stages.binning * 1000.0, r.stages.raster * 1000.0,
+               r.stages.resolve * 1000.0);
+        printf("    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+static bool parseOptions(int argc, char** argv, BenchmarkOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--scalar") == 0) {
+            options.scalar = true;
+            continue;
+        }
+        if (!value) return false;
+        ++i;
+        
+        if (strcmp(arg, "--objects") == 0) options.objects = atoi(value);
+        else if (strcmp(arg, "--layers") == 0) options.layers = atoi(value);
+        else if (strcmp(arg, "--frames") == 0) options.frames = std::max(1, atoi(value));
+        else if (strcmp(arg, "--threads") == 0) options.threads = (unsigned)atoi(value);
+        else if (strcmp(arg, "--scenes") == 0) options.scenes = splitList(value);
+        else if (strcmp(arg, "--modes") == 0) options.modes = splitList(value);
+        else if (strcmp(arg, "--resolutions") == 0) {
+            options.resolutions.clear();
+            for (const auto& item : splitList(value)) {
+                int width = 0, height = 0;
+                if (sscanf(item.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) return false;
+                options.resolutions.push_back({ width, height });
+            }
+        }
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--objects N] [--layers N] [--frames N] [--resolutions WxH,...]\n"
+                        "       [--scenes objects,ground,overdraw] [--modes untiled,tiled,visibility,visibility-tiled]\n"
+                        "       [--threads N] [--scalar]\n", argv[0]);
+        return 1;
+    }
+    
+    std::vector<BenchmarkResult> results;
+    for (const auto& scene : options.scenes) {
+        std::vector<Mesh> meshes;
+        if (scene == "objects") meshes = buildObjectsScene(options.objects);
+        else if (scene == "ground") meshes = buildGroundScene();
+        else if (scene == "overdraw") meshes = buildOverdrawScene(options.layers);
+        else {
+            fprintf(stderr, "unknown scene '%s'\n", scene.c_str());
+            return 1;
+        }
+        
+        for (const auto& resolution : options.resolutions) {
+            for (const auto& mode : options.modes) {
+                if (!isKnownMode(mode)) {
+                    fprintf(stderr, "unknown mode '%s'\n", mode.c_str());
+                    return 1;
+                }
+                BenchmarkResult result = runBenchmark(scene, meshes, resolution.first, resolution.second, mode, options);
+                fprintf(stderr, "%-8s %4dx%-4d %-16s %8.3f ms/frame\n", scene.c_str(), result.width, result.height, mode.c_str(), result.meanMs);
+                results.push_back(result);
+            }
+        }
+    }
+    
+    printJson(results, options);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// render_bridge.h
+// Puts RenderSystem frames on screen through the 2D Renderer, without the
+// copyColorTo + swizzle round trip. A linear FrameBuffer is presented in
+// place; a tiled one is detiled and converted straight into the Renderer's
+// buffer in one pass.
+#pragma once
+
+#include "render_system.h"
+#include "renderer.h"
+
+namespace frame {
+
+	static_assert(sizeof(::Color) == 4, "FrameBuffer pixels must be 32-bit RGBA");
+
+	// Makes the frame buffer's color storage the Renderer's buffer, so every
+	// present shows the RenderSystem's output with no copy or conversion and
+	// 2D draws land on top of it. False for the tiled layout, which the window
+	// cannot read; use copyFrameBuffer there. A lazily cleared frame buffer
+	// must be resolve()d before each present. The frame buffer must outlive
+	// the binding (see Renderer::SetExternalBuffer).
+	inline bool bindFrameBuffer(FrameBuffer& frameBuffer) {
+		if (frameBuffer.isTiled())
+			return false;
+
+		Renderer::SetExternalBuffer(frameBuffer.colorBuffer.data(), frameBuffer.width, frameBuffer.height,
+			frameBuffer.width * (int)sizeof(::Color), PixelFormat::RGBA);
+		return true;
+	}
+
+	// Copies the frame buffer to x, y of the Renderer's buffer, detiling and
+	// swizzling in the same pass. Blocks whose lazy clear is still pending are
+	// filled with the clear color instead of being read.
+	inline void copyFrameBuffer(const FrameBuffer& frameBuffer, int x = 0, int y = 0) {
+		const int tileSize = frameBuffer.isTiled() ? RS_BLOCK_SIZE : 0;
+		Renderer::CopyPixels(frameBuffer.colorBuffer.data(), frameBuffer.width, frameBuffer.height,
+			frameBuffer.width * (int)sizeof(::Color), PixelFormat::RGBA, x, y, tileSize);
+
+		if (!frameBuffer.getFormat().lazyClear)
+			return;
+
+		// runs of pending blocks along each block row go out as one rectangle
+		for (int blockY = 0; blockY < frameBuffer.blocksY; blockY++) {
+			int startY = blockY * RS_BLOCK_SIZE;
+			int rows = std::min(RS_BLOCK_SIZE, frameBuffer.height - startY);
+
+			for (int blockX = 0; blockX < frameBuffer.blocksX;) {
+				if (!frameBuffer.isClearPending(blockX * RS_BLOCK_SIZE, startY)) {
+					blockX++;
+					continue;
+				}
+
+				int runStart = blockX;
+				while (blockX < frameBuffer.blocksX && frameBuffer.isClearPending(blockX * RS_BLOCK_SIZE, startY))
+					blockX++;
+
+				int startX = runStart * RS_BLOCK_SIZE;
+				int endX = std::min(blockX * RS_BLOCK_SIZE, frameBuffer.width);
+				::Color clear = frameBuffer.getColor(startX, startY);
+				Renderer::FillRectangle({ x + startX, y + startY, endX - startX, rows }, { clear.r, clear.g, clear.b });
+			}
+		}
+	}
+}
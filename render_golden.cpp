@@ -0,0 +1,380 @@
+// render_golden.cpp
+// Golden-image harness for the software rasterizer. Renders a fixed scene
+// catalogue through every rendering path (scalar and SIMD kernels, untiled
+// and tile-binned multithreaded mode, linear and tiled frame buffer layout
+// with lazy clears, forward and visibility-buffer shading) and compares each
+// image against a stored reference.
+// Any pixel whose channels differ by more than the tolerance fails the run,
+// and a diff image is written next to the failing output.
+//
+// Build:
+//   g++ -std=c++17 -O2 -mavx2 -pthread render_golden.cpp -o render_golden
+//   cl /std:c++17 /O2 /arch:AVX2 /EHsc render_golden.cpp
+//
+// Usage:
+//   render_golden --update [--dir DIR]   record references from this build
+//   render_golden [--dir DIR] [--tolerance N] [--max-pixels N]
+// References are binary PPM files, DIR/<scene>.ppm (default DIR: golden).
+// The references in golden/ are checked in, so run from the repository root
+// to compare against them. Re-record them with --update only for a change
+// that is meant to alter the images, and review the new files before
+// committing them.
+// Failures write DIR/<scene>.<path>.ppm and DIR/<scene>.<path>.diff.ppm.
+// The exit code is 0 when every path matches, 1 on mismatch and 2 on error.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+
+#include "render_system.h"
+
+struct GoldenScene {
+    const char* name;
+    int width, height;
+    std::function<void(RenderSystem&, Camera&, FrameBuffer&)> draw;
+};
+
+struct RenderPath {
+    const char* name;
+    bool simd;
+    bool tiled;
+    FrameBufferLayout layout;
+    bool lazyClear;
+    bool visibility;
+};
+
+static const RenderPath renderPaths[] = {
+    { "scalar",            false, false, FrameBufferLayout::Linear, false, false },
+    { "simd",              true,  false, FrameBufferLayout::Linear, false, false },
+    { "scalar-tiled",      false, true,  FrameBufferLayout::Linear, false, false },
+    { "simd-tiled",        true,  true,  FrameBufferLayout::Linear, false, false },
+    { "simd-blocks",       true,  false, FrameBufferLayout::Tiled,  true,  false },
+    { "tiled-blocks",      true,  true,  FrameBufferLayout::Tiled,  true,  false },
+    { "visibility",        true,  false, FrameBufferLayout::Linear, false, true  },
+    { "visibility-scalar", false, false, FrameBufferLayout::Linear, false, true  },
+    { "visibility-tiled",  true,  true,  FrameBufferLayout::Tiled,  true,  true  }
+};
+
+static Mesh offsetMesh(Mesh mesh, const vector3& offset) {
+    for (auto& tri : mesh.triangles) {
+        tri.v0.position = tri.v0.position + offset;
+        tri.v1.position = tri.v1.position + offset;
+        tri.v2.position = tri.v2.position + offset;
+    }
+    mesh.markBoundsDirty();
+    return mesh;
+}
+
+// Mesh whose vertices each get a distinct color, so interpolation errors show
+static Mesh rainbowMesh(Mesh mesh) {
+    int corner = 0;
+    for (auto& tri : mesh.triangles) {
+        for (Vertex* v : { &tri.v0, &tri.v1, &tri.v2 }) {
+            v->color = Color((uint8_t)(corner * 67), (uint8_t)(corner * 131 + 40), (uint8_t)(255 - corner * 29));
+            ++corner;
+        }
+    }
+    return mesh;
+}
+
+static std::vector<GoldenScene> buildCatalogue() {
+    std::vector<GoldenScene> scenes;
+    
+    // Generated shapes with per-vertex colors, seen at an angle
+    scenes.push_back({ "shapes", 320, 180, [](RenderSystem& renderer, Camera& camera, FrameBuffer&) {
+        camera.position = vector3(0, 1.5f, -4);
+        camera.updateBasis(0.2f, -0.25f);
+        std::vector<Mesh> meshes;
+        for (int i = 0; i < 12; ++i) {
+            vector3 offset((i % 4) * 1.6f - 2.4f, 0, (i / 4) * 1.8f);
+            Mesh mesh = (i % 2) ? MeshGenerators::createCube(1.0f) : MeshGenerators::createPyramid(1.0f, 1.4f);
+            meshes.push_back(offsetMesh(rainbowMesh(mesh), offset));
+        }
+        renderer.setCullMode(CullMode::None);
+        renderer.renderScene(meshes);
+    } });
+    
+    // Triangle fan and grid sharing every edge: the fill rule must cover
+    // each pixel exactly once, leaving neither cracks nor double blends
+    scenes.push_back({ "shared-edges", 257, 161, [](RenderSystem& renderer, Camera& camera, FrameBuffer&) {
+        camera.position = vector3(0, 0, -3);
+        Mesh fan;
+        const int segments = 37;
+        for (int i = 0; i < segments; ++i) {
+            float a0 = 6.2831853f * i / segments, a1 = 6.2831853f * (i + 1) / segments;
+            Color color((uint8_t)(i * 7), (uint8_t)(255 - i * 5), (uint8_t)(i * 3 + 60));
+            fan.addTriangle(Vertex(vector3(-1.2f, 0.1f, 0), color),
+                            Vertex(vector3(-1.2f + 0.9f * cosf(a0), 0.1f + 0.9f * sinf(a0), 0), color),
+                            Vertex(vector3(-1.2f + 0.9f * cosf(a1), 0.1f + 0.9f * sinf(a1), 0), color));
+        }
+        Mesh grid;
+        for (int y = 0; y < 9; ++y) {
+            for (int x = 0; x < 9; ++x) {
+                Color color((uint8_t)(x * 28), (uint8_t)(y * 28), 200);
+                vector3 p0(0.2f + x * 0.17f, -0.8f + y * 0.19f, 0), p1 = p0 + vector3(0.17f, 0, 0);
+                vector3 p2 = p0 + vector3(0.17f, 0.19f, 0), p3 = p0 + vector3(0, 0.19f, 0);
+                grid.addTriangle(Vertex(p0, color), Vertex(p3, color), Vertex(p2, color));
+                grid.addTriangle(Vertex(p0, color), Vertex(p2, color), Vertex(p1, color));
+            }
+        }
+        renderer.setCullMode(CullMode::None);
+        renderer.renderMesh(fan);
+        renderer.renderMesh(grid);
+    } });
+    
+    // Ground plane through the near plane and far past the guard band
+    scenes.push_back({ "clipping", 320, 200, [](RenderSystem& renderer, Camera& camera, FrameBuffer&) {
+        camera.position = vector3(0, 0.5f, 0);
+        camera.updateBasis(0.4f, -0.1f);
+        Mesh ground;
+        const float extent = 500.0f;
+        ground.addTriangle(Vertex(vector3(-extent, 0, -extent), Color(255, 0, 0)), Vertex(vector3(-extent, 0, extent), Color(0, 255, 0)),
+                           Vertex(vector3(extent, 0, extent), Color(0, 0, 255)));
+        ground.addTriangle(Vertex(vector3(-extent, 0, -extent), Color(255, 0, 0)), Vertex(vector3(extent, 0, extent), Color(0, 0, 255)),
+                           Vertex(vector3(extent, 0, -extent), Color(255, 255, 0)));
+        renderer.setCullMode(CullMode::None);
+        renderer.renderMesh(ground);
+    } });
+    
+    // Interpenetrating triangles and a back-to-front overdraw stack
+    scenes.push_back({ "depth", 300, 200, [](RenderSystem& renderer, Camera& camera, FrameBuffer&) {
+        camera.position = vector3(0, 0, -4);
+        std::vector<Mesh> meshes;
+        for (int i = 0; i < 8; ++i) {
+            float z = 4.0f - i * 0.5f;
+            Color color((uint8_t)(30 * i), (uint8_t)(200 - 20 * i), 128);
+            Mesh quad(color);
+            float x = -1.5f + i * 0.2f;
+            quad.addTriangle(Vertex(vector3(x, -1, z), color), Vertex(vector3(x, 1, z), color), Vertex(vector3(x + 1.5f, 1, z), color));
+            quad.addTriangle(Vertex(vector3(x, -1, z), color), Vertex(vector3(x + 1.5f, 1, z), color), Vertex(vector3(x + 1.5f, -1, z), color));
+            meshes.push_back(quad);
+        }
+        Mesh crossing;
+        crossing.addTriangle(Vertex(vector3(-2, -1.5f, 0), Color(255, 0, 0)), Vertex(vector3(2, -1.5f, 4), Color(255, 0, 0)),
+                             Vertex(vector3(0, 1.5f, 2), Color(255, 128, 0)));
+        crossing.addTriangle(Vertex(vector3(-2, -1.5f, 4), Color(0, 0, 255)), Vertex(vector3(2, -1.5f, 0), Color(0, 0, 255)),
+                             Vertex(vector3(0, 1.5f, 2), Color(0, 128, 255)));
+        meshes.push_back(crossing);
+        renderer.setCullMode(CullMode::None);
+        renderer.renderScene(meshes);
+    } });
+    
+    // Slivers and sub-pixel triangles, where snapping and the fill rule decide everything
+    scenes.push_back({ "subpixel", 128, 96, [](RenderSystem& renderer, Camera& camera, FrameBuffer&) {
+        camera.position = vector3(0, 0, -2);
+        Mesh tiny;
+        for (int i = 0; i < 200; ++i) {
+            float x = -1.6f + (i % 20) * 0.16f, y = -0.9f + (i / 20) * 0.18f;
+            float size = 0.002f + (i % 7) * 0.004f;
+            Color color((uint8_t)(i * 13), (uint8_t)(i * 7), (uint8_t)(255 - i));
+            tiny.addTriangle(Vertex(vector3(x, y, 0), color), Vertex(vector3(x + size * 0.3f, y + size * 4.0f, 0), color),
+                             Vertex(vector3(x + size, y + 0.0005f * (i % 3), 0), color));
+        }
+        renderer.setCullMode(CullMode::None);
+        renderer.renderMesh(tiny);
+    } });
+    
+    // Indexed and instanced draws, plus single triangles and direct pixel writes
+    scenes.push_back({ "api-paths", 320, 180, [](RenderSystem& renderer, Camera& camera, FrameBuffer& frameBuffer) {
+        camera.position = vector3(0, 1, -5);
+        camera.updateBasis(-0.15f, -0.15f);
+        renderer.setCullMode(CullMode::Back);
+        renderer.renderMesh(IndexedMesh::fromMesh(offsetMesh(rainbowMesh(MeshGenerators::createPyramid(1.5f, 2.0f)), vector3(-2, 0, 1))));
+        
+        std::vector<Instance> instances;
+        for (int i = 0; i < 6; ++i) {
+            Transform transform = Transform::translation(vector3(0.5f + (i % 3) * 1.3f, (i / 3) * 1.2f - 0.5f, 1.0f + i * 0.4f)) *
+                                  Transform::rotationY(0.5f * i);
+            instances.push_back(Instance(transform, Color(255, (uint8_t)(120 + i * 20), (uint8_t)(255 - i * 30))));
+        }
+        IndexedMesh cube = IndexedMesh::fromMesh(rainbowMesh(MeshGenerators::createCube(0.8f)));
+        renderer.setCullMode(CullMode::None);
+        renderer.renderInstanced(cube, instances);
+        
+        renderer.rasterizeTriangle(Triangle(Vertex(vector3(-3, -1.5f, 3), Color(255, 255, 255)),
+                                            Vertex(vector3(-1, -0.5f, 3), Color(0, 0, 0)),
+                                            Vertex(vector3(-3, -0.5f, 3), Color(255, 0, 255))));
+        for (int i = 0; i < 64; ++i) frameBuffer.setPixel(10 + i * 4, 170 - (i % 8), Color(255, 255, (uint8_t)(i * 4)), 0.5f);
+    } });
+    
+    // Checkered ground receding through every mip level, tinted by its
+    // vertex colors, and a textured indexed cube with wrapping UVs
+    scenes.push_back({ "textured", 320, 180, [](RenderSystem& renderer, Camera& camera, FrameBuffer&) {
+        static Texture checker;
+        if (checker.isEmpty()) {
+            std::vector<Color> texels(64 * 32);
+            for (int y = 0; y < 32; ++y) {
+                for (int x = 0; x < 64; ++x) {
+                    bool light = ((x >> 2) ^ (y >> 2)) & 1;
+                    texels[y * 64 + x] = light ? Color(250, 240, 220) : Color((uint8_t)(x * 4), 60, (uint8_t)(255 - y * 8));
+                }
+            }
+            checker.create(64, 32, texels.data());
+        }
+        camera.position = vector3(0, 1, -3);
+        camera.updateBasis(0.1f, -0.2f);
+        renderer.setCullMode(CullMode::None);
+        
+        Mesh ground;
+        ground.texture = &checker;
+        const float extent = 60.0f;
+        const vector3 corners[4] = { vector3(-extent, 0, -2), vector3(-extent, 0, extent), vector3(extent, 0, extent), vector3(extent, 0, -2) };
+        const Color tints[4] = { Color(255, 255, 255), Color(255, 160, 160), Color(160, 255, 160), Color(160, 160, 255) };
+        Vertex v[4];
+        for (int i = 0; i < 4; ++i) v[i] = Vertex(corners[i], tints[i], corners[i].x * 0.25f, corners[i].z * 0.5f);
+        ground.addTriangle(v[0], v[1], v[2]);
+        ground.addTriangle(v[0], v[2], v[3]);
+        renderer.renderMesh(ground);
+        
+        Mesh cube = offsetMesh(MeshGenerators::createCube(1.2f), vector3(0.8f, 0.8f, 1.5f));
+        for (auto& tri : cube.triangles) {
+            for (Vertex* vertex : { &tri.v0, &tri.v1, &tri.v2 }) {
+                vertex->u = (vertex->position.x + vertex->position.z) * 1.5f;
+                vertex->v = vertex->position.y * 3.0f;
+            }
+        }
+        IndexedMesh indexedCube = IndexedMesh::fromMesh(cube);
+        indexedCube.texture = &checker;
+        renderer.renderMesh(indexedCube);
+    } });
+    
+    return scenes;
+}
+
+static std::vector<Color> renderScene(const GoldenScene& scene, const RenderPath& path) {
+    FrameBufferFormat format;
+    format.layout = path.layout;
+    format.lazyClear = path.lazyClear;
+    FrameBuffer frameBuffer(scene.width, scene.height, format);
+    Camera camera;
+    camera.setFrustum(90.0f, (float)scene.width / scene.height, 0.1f, 1000.0f);
+    RenderSystem renderer(frameBuffer, camera);
+    renderer.setSimdEnabled(path.simd);
+    if (path.tiled) renderer.setTiledMode(true, 32, 4);
+    renderer.setVisibilityBufferEnabled(path.visibility);
+    
+    frameBuffer.clear(Color(16, 16, 24, 255), FLT_MAX);
+    scene.draw(renderer, camera, frameBuffer);
+    renderer.resolveVisibility();
+    
+    std::vector<Color> pixels(scene.width * scene.height);
+    frameBuffer.copyColorTo(pixels.data());
+    return pixels;
+}
+
+static bool writePpm(const std::string& path, int width, int height, const std::vector<Color>& pixels) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    std::vector<uint8_t> rgb(pixels.size() * 3);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        rgb[i * 3] = pixels[i].r;
+        rgb[i * 3 + 1] = pixels[i].g;
+        rgb[i * 3 + 2] = pixels[i].b;
+    }
+    bool ok = fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    return fclose(file) == 0 && ok;
+}
+
+static bool readPpm(const std::string& path, int& width, int& height, std::vector<Color>& pixels) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    int maxValue = 0;
+    bool ok = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 && maxValue == 255 && width > 0 && height > 0;
+    ok = ok && fgetc(file) != EOF;
+    if (ok) {
+        std::vector<uint8_t> rgb((size_t)width * height * 3);
+        ok = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+        pixels.resize((size_t)width * height);
+        for (size_t i = 0; ok && i < pixels.size(); ++i) pixels[i] = Color(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+    }
+    fclose(file);
+    return ok;
+}
+
+// Counts pixels whose RGB channels differ by more than tolerance. The diff
+// image shows the reference dimmed to gray with mismatches in red, brighter
+// for larger differences.
+static int comparePixels(const std::vector<Color>& reference, const std::vector<Color>& image, int tolerance,
+                         std::vector<Color>& diff, int& largest) {
+    int mismatches = 0;
+    largest = 0;
+    diff.resize(reference.size());
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const Color& a = reference[i];
+        const Color& b = image[i];
+        int delta = std::max(std::abs(a.r - b.r), std::max(std::abs(a.g - b.g), std::abs(a.b - b.b)));
+        largest = std::max(largest, delta);
+        if (delta > tolerance) {
+            ++mismatches;
+            diff[i] = Color(255, (uint8_t)std::max(0, 160 - delta), 0);
+        }
+        else {
+            uint8_t gray = (uint8_t)((a.r + a.g + a.b) / 12);
+            diff[i] = Color(gray, gray, gray);
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    std::string directory = "golden";
+    bool update = false;
+    int tolerance = 0, maxPixels = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--update") == 0) update = true;
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) directory = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) tolerance = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-pixels") == 0 && i + 1 < argc) maxPixels = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--update] [--dir DIR] [--tolerance N] [--max-pixels N]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    std::vector<GoldenScene> scenes = buildCatalogue();
+    std::error_code error;
+    if (update) std::filesystem::create_directories(directory, error);
+    int failures = 0;
+    for (const auto& scene : scenes) {
+        std::string referencePath = directory + "/" + scene.name + ".ppm";
+        if (update) {
+            // References come from the scalar untiled path, the plainest one
+            if (!writePpm(referencePath, scene.width, scene.height, renderScene(scene, renderPaths[0]))) {
+                fprintf(stderr, "cannot write %s\n", referencePath.c_str());
+                return 2;
+            }
+            printf("recorded %s\n", referencePath.c_str());
+            continue;
+        }
+        
+        int width = 0, height = 0;
+        std::vector<Color> reference;
+        if (!readPpm(referencePath, width, height, reference) || width != scene.width || height != scene.height) {
+            fprintf(stderr, "missing or invalid reference %s; run with --update on a trusted build\n", referencePath.c_str());
+            return 2;
+        }
+        
+        for (const auto& path : renderPaths) {
+            std::vector<Color> image = renderScene(scene, path);
+            std::vector<Color> diff;
+            int largest = 0;
+            int mismatches = comparePixels(reference, image, tolerance, diff, largest);
+            bool passed = mismatches <= maxPixels;
+            printf("%-4s %-14s %-17s %6d pixels differ, largest channel delta %d\n",
+                   passed ? "ok" : "FAIL", scene.name, path.name, mismatches, largest);
+            if (passed) continue;
+            
+            ++failures;
+            std::string prefix = directory + "/" + scene.name + "." + path.name;
+            writePpm(prefix + ".ppm", width, height, image);
+            writePpm(prefix + ".diff.ppm", width, height, diff);
+        }
+    }
+    
+    if (!update) printf("%d failure%s\n", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -6,6 +6,36 @@
 #include <vector>
 #include <cstdint>
 #include <algorithm>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <cfloat>
+#include <chrono>
+#include <queue>
+#include <utility>
+
+#include "worker_pool.h"
+
+// Widest SIMD rasterizer kernel the compiler targets; 1 means scalar only
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RS_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RS_SIMD_WIDTH 4
+#else
+#define RS_SIMD_WIDTH 1
+#endif
+
+// Sub-pixel precision of the fixed-point rasterizer and its coverage block size.
+// Screen coordinates must stay within RS_GUARD_BAND pixels so the 64-bit setup
+// and 32-bit in-block stepping cannot overflow; primitive assembly clips
+// against RS_CLIP_GUARD_BAND, which leaves room for float rounding.
+#define RS_SUBPIXEL_BITS 4
+#define RS_BLOCK_SIZE 8
+#define RS_GUARD_BAND 8192.0f
+#define RS_CLIP_GUARD_BAND (RS_GUARD_BAND - 64.0f)
 
 // vector3 with all necessary operations
 struct vector3 {
@@ -41,6 +71,128 @@ struct Color {
     Color(uint8_t r = 255, uint8_t g = 255, uint8_t b = 255, uint8_t a = 255) : r(r), g(g), b(b), a(a) {}
 };
 
+// Axis-aligned bounding box; default constructed boxes are empty
+struct BoundingBox {
+    vector3 min, max;
+    
+    BoundingBox() : min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+    BoundingBox(const vector3& minPoint, const vector3& maxPoint) : min(minPoint), max(maxPoint) {}
+    
+    bool isEmpty() const { return min.x > max.x; }
+    
+    vector3 getCenter() const { return (min + max) * 0.5f; }
+    vector3 getExtents() const { return (max - min) * 0.5f; }
+    
+    void expand(const vector3& p) {
+        min = vector3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = vector3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+    
+    void expand(const BoundingBox& other) {
+        if (other.isEmpty()) return;
+        expand(other.min);
+        expand(other.max);
+    }
+    
+    bool operator==(const BoundingBox& other) const {
+        return min.x == other.min.x && min.y == other.min.y && min.z == other.min.z &&
+               max.x == other.max.x && max.y == other.max.y && max.z == other.max.z;
+    }
+};
+
+// Bounding sphere
+struct BoundingSphere {
+    vector3 center;
+    float radius;
+    
+    BoundingSphere(const vector3& c = vector3(), float r = -1.0f) : center(c), radius(r) {}
+    
+    bool isEmpty() const { return radius < 0; }
+};
+
+// Affine transform: the top three rows of a 4x4 matrix acting on column
+// vectors, p' = m * (p, 1)
+struct Transform {
+    float m[3][4];
+    
+    Transform() {
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) m[row][col] = row == col ? 1.0f : 0.0f;
+        }
+    }
+    
+    static Transform translation(const vector3& offset) {
+        Transform t;
+        t.m[0][3] = offset.x;
+        t.m[1][3] = offset.y;
+        t.m[2][3] = offset.z;
+        return t;
+    }
+    
+    static Transform scale(const vector3& factors) {
+        Transform t;
+        t.m[0][0] = factors.x;
+        t.m[1][1] = factors.y;
+        t.m[2][2] = factors.z;
+        return t;
+    }
+    
+    // Rotation about the y axis, matching the yaw of Camera::updateBasis
+    static Transform rotationY(float angle) {
+        Transform t;
+        float sinA = sinf(angle), cosA = cosf(angle);
+        t.m[0][0] = cosA;
+        t.m[0][2] = sinA;
+        t.m[2][0] = -sinA;
+        t.m[2][2] = cosA;
+        return t;
+    }
+    
+    // Composition; other is applied first
+    Transform operator*(const Transform& other) const {
+        Transform t;
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) {
+                t.m[row][col] = m[row][0] * other.m[0][col] + m[row][1] * other.m[1][col] + m[row][2] * other.m[2][col];
+            }
+            t.m[row][3] += m[row][3];
+        }
+        return t;
+    }
+    
+    vector3 transformPoint(const vector3& p) const {
+        return vector3(m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                       m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                       m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+    }
+    
+    vector3 transformDirection(const vector3& d) const {
+        return vector3(m[0][0] * d.x + m[0][1] * d.y + m[0][2] * d.z,
+                       m[1][0] * d.x + m[1][1] * d.y + m[1][2] * d.z,
+                       m[2][0] * d.x + m[2][1] * d.y + m[2][2] * d.z);
+    }
+    
+    // Smallest axis-aligned box around the transformed box, built from the
+    // per-axis extremes of each matrix term instead of all eight corners
+    BoundingBox transformBox(const BoundingBox& box) const {
+        if (box.isEmpty()) return box;
+        
+        const float boxMin[3] = { box.min.x, box.min.y, box.min.z };
+        const float boxMax[3] = { box.max.x, box.max.y, box.max.z };
+        float outMin[3], outMax[3];
+        for (int row = 0; row < 3; ++row) {
+            outMin[row] = outMax[row] = m[row][3];
+            for (int col = 0; col < 3; ++col) {
+                float a = m[row][col] * boxMin[col];
+                float b = m[row][col] * boxMax[col];
+                outMin[row] += std::min(a, b);
+                outMax[row] += std::max(a, b);
+            }
+        }
+        return BoundingBox(vector3(outMin[0], outMin[1], outMin[2]), vector3(outMax[0], outMax[1], outMax[2]));
+    }
+};
+
 // Camera with precomputed basis vectors
 struct Camera {
     vector3 position;
@@ -73,6 +225,19 @@ struct Camera {
         return vector3(translated.dot(right), translated.dot(up), translated.dot(forward));
     }
     
+    // worldToCameraSpace as a matrix, for composing with model transforms
+    Transform getViewTransform() const {
+        Transform t;
+        const vector3 axes[3] = { right, up, forward };
+        for (int row = 0; row < 3; ++row) {
+            t.m[row][0] = axes[row].x;
+            t.m[row][1] = axes[row].y;
+            t.m[row][2] = axes[row].z;
+            t.m[row][3] = -axes[row].dot(position);
+        }
+        return t;
+    }
+    
     bool boundsCheck(const vector3& point) const {
         vector3 cameraSpace = worldToCameraSpace(point);
         if (cameraSpace.z < nearZ) return false;
@@ -86,38 +251,510 @@ struct Camera {
     }
 };
 
-// Frame buffer with color and depth
+// Camera view volume as six inward-facing world-space planes:
+// near, far, left, right, top, bottom
+struct Frustum {
+    static const int planeCount = 6;
+    static const uint32_t allPlanes = (1u << planeCount) - 1;
+    
+    vector3 normals[planeCount];
+    float distances[planeCount];
+    
+    Frustum() {}
+    
+    explicit Frustum(const Camera& camera) {
+        setPlane(0, camera.forward, camera.nearZ, camera.position);
+        setPlane(1, camera.forward * -1.0f, -camera.farZ, camera.position);
+        setPlane(2, camera.right + camera.forward * camera.tanHalfFovX, 0.0f, camera.position);
+        setPlane(3, camera.forward * camera.tanHalfFovX - camera.right, 0.0f, camera.position);
+        setPlane(4, camera.forward * camera.tanHalfFovY - camera.up, 0.0f, camera.position);
+        setPlane(5, camera.up + camera.forward * camera.tanHalfFovY, 0.0f, camera.position);
+    }
+    
+    bool intersects(const BoundingSphere& sphere) const {
+        for (int i = 0; i < planeCount; ++i) {
+            if (normals[i].dot(sphere.center) + distances[i] < -sphere.radius) return false;
+        }
+        return true;
+    }
+    
+    bool intersects(const BoundingBox& box) const {
+        uint32_t planeMask = allPlanes;
+        return classify(box, planeMask);
+    }
+    
+    // Tests the box against the planes in planeMask. Returns false when the
+    // box is outside one of them; otherwise clears the bits of the planes the
+    // box is entirely inside, so children of a hierarchy can skip them.
+    bool classify(const BoundingBox& box, uint32_t& planeMask) const {
+        vector3 center = box.getCenter();
+        vector3 extents = box.getExtents();
+        for (int i = 0; i < planeCount; ++i) {
+            if (!(planeMask & (1u << i))) continue;
+            
+            const vector3& n = normals[i];
+            float distance = n.dot(center) + distances[i];
+            float radius = extents.x * fabsf(n.x) + extents.y * fabsf(n.y) + extents.z * fabsf(n.z);
+            if (distance < -radius) return false;
+            if (distance >= radius) planeMask &= ~(1u << i);
+        }
+        return true;
+    }
+
+private:
+    // Plane n.p + d >= 0 through origin, shifted offset units along the
+    // normal; normalized so sphere tests compare against the radius directly
+    void setPlane(int index, const vector3& normal, float offset, const vector3& origin) {
+        normals[index] = normal.normalize();
+        distances[index] = -normals[index].dot(origin) - offset;
+    }
+};
+
+// Storage format of FrameBuffer depth. Unorm formats map the depth range
+// [depthNear, depthFar] linearly onto their integer range, trading precision
+// for memory bandwidth; depths outside the range clamp to its ends.
+enum class DepthFormat {
+    Float32,
+    Unorm24, // low 24 bits of a 32-bit word
+    Unorm16
+};
+
+// Pixel order of FrameBuffer storage
+enum class FrameBufferLayout {
+    Linear, // row-major
+    Tiled   // RS_BLOCK_SIZE square tiles in row-major tile order, one coverage block per tile
+};
+
+struct FrameBufferFormat {
+    FrameBufferLayout layout = FrameBufferLayout::Linear;
+    DepthFormat depthFormat = DepthFormat::Float32;
+    float depthNear = 0.0f, depthFar = 1.0f;
+    bool lazyClear = false; // clear() only flags blocks; resolve() before reading the buffers directly
+};
+
+// Frame buffer with color and depth.
+// Storage is split into RS_BLOCK_SIZE blocks, which are also the tiles of the
+// tiled layout; pixelIndex maps coordinates to storage in either layout.
+// Depth is compared and stored as a key: the camera depth itself for Float32,
+// the quantized integer value for unorm formats.
+// hiZ keeps one conservative maximum depth per block: no pixel in the block
+// ends the frame farther away than that. Writes that only lower depth keep it
+// valid; code that raises depth values directly must call rebuildHiZ
+// afterwards.
+// With lazy clear, clear() costs one flag per block and a block is filled
+// with the clear values when it is first drawn to or resolved.
+// The visibility buffer, allocated on first use by visibility-buffer
+// rendering, holds the ID of the triangle that won each pixel, 0 for none;
+// it is cleared along with color and depth.
 struct FrameBuffer {
     int width, height;
     std::vector<Color> colorBuffer;
-    std::vector<float> depthBuffer;
+    std::vector<float> depthBuffer;      // Float32 depth
+    std::vector<uint32_t> depthBuffer24; // Unorm24 depth
+    std::vector<uint16_t> depthBuffer16; // Unorm16 depth
+    std::vector<uint32_t> visibilityBuffer;
+    int blocksX, blocksY;
+    std::vector<float> hiZ;
+    std::vector<uint8_t> pendingClear;
+    
+    FrameBuffer(int w, int h, const FrameBufferFormat& fmt = FrameBufferFormat()) : width(w), height(h), format(fmt) {
+        blocksX = (w + RS_BLOCK_SIZE - 1) / RS_BLOCK_SIZE;
+        blocksY = (h + RS_BLOCK_SIZE - 1) / RS_BLOCK_SIZE;
+        depthMaxValue = format.depthFormat == DepthFormat::Unorm24 ? (float)0xFFFFFF : (float)0xFFFF;
+        depthScale = depthMaxValue / (format.depthFar - format.depthNear);
+        
+        size_t pixelCount = isTiled() ? (size_t)blocksX * blocksY * RS_BLOCK_SIZE * RS_BLOCK_SIZE : (size_t)w * h;
+        clearColor = Color(0, 0, 0, 255);
+        clearDepthKey = encodeDepth(1.0f);
+        colorBuffer.resize(pixelCount, clearColor);
+        switch (format.depthFormat) {
+            case DepthFormat::Float32: depthBuffer.resize(pixelCount, clearDepthKey); break;
+            case DepthFormat::Unorm24: depthBuffer24.resize(pixelCount, (uint32_t)clearDepthKey); break;
+            case DepthFormat::Unorm16: depthBuffer16.resize(pixelCount, (uint16_t)clearDepthKey); break;
+        }
+        hiZ.resize(blocksX * blocksY, decodeDepth(clearDepthKey));
+        pendingClear.resize(blocksX * blocksY, 0);
+    }
+    
+    const FrameBufferFormat& getFormat() const { return format; }
+    bool isTiled() const { return format.layout == FrameBufferLayout::Tiled; }
+    
+    // Storage index of a pixel. The pixels of one block row are contiguous
+    // in both layouts.
+    int pixelIndex(int x, int y) const {
+        if (!isTiled()) return y * width + x;
+        int block = (y / RS_BLOCK_SIZE) * blocksX + x / RS_BLOCK_SIZE;
+        return block * RS_BLOCK_SIZE * RS_BLOCK_SIZE + (y % RS_BLOCK_SIZE) * RS_BLOCK_SIZE + x % RS_BLOCK_SIZE;
+    }
+    
+    static float quantizeDepth(float z, float depthNear, float depthScale, float maxValue) {
+        return std::nearbyint(std::min(std::max((z - depthNear) * depthScale, 0.0f), maxValue));
+    }
+    
+    float encodeDepth(float z) const {
+        if (format.depthFormat == DepthFormat::Float32) return z;
+        return quantizeDepth(z, format.depthNear, depthScale, depthMaxValue);
+    }
     
-    FrameBuffer(int w, int h) : width(w), height(h) {
-        colorBuffer.resize(w * h, Color(0, 0, 0, 255));
-        depthBuffer.resize(w * h, 1.0f);
+    float decodeDepth(float key) const {
+        if (format.depthFormat == DepthFormat::Float32) return key;
+        return format.depthNear + key / depthScale;
     }
     
-    void clear(Color clearColor = Color(0, 0, 0, 255), float depth = 1.0f) {
+    float getDepthScale() const { return depthScale; }
+    float getDepthMaxValue() const { return depthMaxValue; }
+    
+    void enableVisibilityBuffer() {
+        if (visibilityBuffer.empty()) visibilityBuffer.resize(colorBuffer.size(), 0);
+    }
+    
+    void clear(Color color = Color(0, 0, 0, 255), float depth = 1.0f) {
+        clearColor = color;
+        clearDepthKey = encodeDepth(depth);
+        std::fill(hiZ.begin(), hiZ.end(), decodeDepth(clearDepthKey));
+        if (format.lazyClear) {
+            std::fill(pendingClear.begin(), pendingClear.end(), 1);
+            return;
+        }
+        
         std::fill(colorBuffer.begin(), colorBuffer.end(), clearColor);
-        std::fill(depthBuffer.begin(), depthBuffer.end(), depth);
+        std::fill(depthBuffer.begin(), depthBuffer.end(), clearDepthKey);
+        std::fill(depthBuffer24.begin(), depthBuffer24.end(), (uint32_t)clearDepthKey);
+        std::fill(depthBuffer16.begin(), depthBuffer16.end(), (uint16_t)clearDepthKey);
+        std::fill(visibilityBuffer.begin(), visibilityBuffer.end(), 0u);
+    }
+    
+    // Fills a block with the clear values if its clear is still pending
+    void resolveBlock(int blockX, int blockY) {
+        uint8_t& pending = pendingClear[blockY * blocksX + blockX];
+        if (!pending) return;
+        pending = 0;
+        
+        forEachBlockRow(blockX, blockY, [&](int index, int count) {
+            std::fill_n(colorBuffer.begin() + index, count, clearColor);
+            switch (format.depthFormat) {
+                case DepthFormat::Float32: std::fill_n(depthBuffer.begin() + index, count, clearDepthKey); break;
+                case DepthFormat::Unorm24: std::fill_n(depthBuffer24.begin() + index, count, (uint32_t)clearDepthKey); break;
+                case DepthFormat::Unorm16: std::fill_n(depthBuffer16.begin() + index, count, (uint16_t)clearDepthKey); break;
+            }
+            if (!visibilityBuffer.empty()) std::fill_n(visibilityBuffer.begin() + index, count, 0u);
+        });
+    }
+    
+    // Completes every pending clear, after which the buffers can be read directly
+    void resolve() {
+        for (int by = 0; by < blocksY; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) resolveBlock(bx, by);
+        }
+    }
+    
+    bool isClearPending(int x, int y) const {
+        return pendingClear[(y / RS_BLOCK_SIZE) * blocksX + x / RS_BLOCK_SIZE] != 0;
+    }
+    
+    // Readback that sees pending clears without resolving them
+    Color getColor(int x, int y) const {
+        return isClearPending(x, y) ? clearColor : colorBuffer[pixelIndex(x, y)];
+    }
+    
+    float getDepth(int x, int y) const {
+        return decodeDepth(isClearPending(x, y) ? clearDepthKey : loadDepthKey(pixelIndex(x, y)));
+    }
+    
+    // Copies the color buffer out in row-major order, whatever the layout
+    void copyColorTo(Color* destination) const {
+        for (int y = 0; y < height; ++y) {
+            Color* row = destination + y * width;
+            for (int bx = 0; bx < blocksX; ++bx) {
+                int startX = bx * RS_BLOCK_SIZE, count = std::min(RS_BLOCK_SIZE, width - startX);
+                if (isClearPending(startX, y)) std::fill_n(row + startX, count, clearColor);
+                else std::copy_n(colorBuffer.begin() + pixelIndex(startX, y), count, row + startX);
+            }
+        }
+    }
+    
+    float getHiZ(int blockX, int blockY) const { return hiZ[blockY * blocksX + blockX]; }
+    
+    // Tightens one block's bound to the farthest depth it currently holds
+    void refreshHiZBlock(int blockX, int blockY) {
+        float maxKey = -FLT_MAX;
+        if (pendingClear[blockY * blocksX + blockX]) maxKey = clearDepthKey;
+        else forEachBlockRow(blockX, blockY, [&](int index, int count) {
+            for (int i = index; i < index + count; ++i) maxKey = std::max(maxKey, loadDepthKey(i));
+        });
+        float& bound = hiZ[blockY * blocksX + blockX];
+        bound = std::min(bound, decodeDepth(maxKey));
+    }
+    
+    // Recomputes every block from the depth buffer
+    void rebuildHiZ() {
+        std::fill(hiZ.begin(), hiZ.end(), FLT_MAX);
+        for (int by = 0; by < blocksY; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) refreshHiZBlock(bx, by);
+        }
     }
     
     void setPixel(int x, int y, const Color& color, float depth) {
         if (x >= 0 && x < width && y >= 0 && y < height) {
-            int index = y * width + x;
-            if (depth < depthBuffer[index]) {
+            resolveBlock(x / RS_BLOCK_SIZE, y / RS_BLOCK_SIZE);
+            int index = pixelIndex(x, y);
+            float key = encodeDepth(depth);
+            if (key < loadDepthKey(index)) {
                 colorBuffer[index] = color;
-                depthBuffer[index] = depth;
+                storeDepthKey(index, key);
+                if (!visibilityBuffer.empty()) visibilityBuffer[index] = 0;
+            }
+        }
+    }
+
+private:
+    FrameBufferFormat format;
+    Color clearColor;
+    float clearDepthKey;
+    float depthScale, depthMaxValue;
+    
+    float loadDepthKey(int index) const {
+        switch (format.depthFormat) {
+            case DepthFormat::Unorm24: return (float)depthBuffer24[index];
+            case DepthFormat::Unorm16: return (float)depthBuffer16[index];
+            default: return depthBuffer[index];
+        }
+    }
+    
+    void storeDepthKey(int index, float key) {
+        switch (format.depthFormat) {
+            case DepthFormat::Unorm24: depthBuffer24[index] = (uint32_t)key; break;
+            case DepthFormat::Unorm16: depthBuffer16[index] = (uint16_t)key; break;
+            default: depthBuffer[index] = key; break;
+        }
+    }
+    
+    // Calls fn(storage index, pixel count) for each row of the block inside the image
+    template <typename Fn>
+    void forEachBlockRow(int blockX, int blockY, Fn&& fn) const {
+        int startX = blockX * RS_BLOCK_SIZE, count = std::min(RS_BLOCK_SIZE, width - startX);
+        int startY = blockY * RS_BLOCK_SIZE, endY = std::min(height, startY + RS_BLOCK_SIZE);
+        for (int y = startY; y < endY; ++y) fn(pixelIndex(startX, y), count);
+    }
+};
+
+// Mipmapped RGBA texture sampled by the rasterizer. Dimensions are powers of
+// two so coordinates wrap with a mask, and the mip chain is box-filtered
+// down to 1x1 when the texture is created. Each level is stored in Morton
+// (Z) order, so the four texels of a bilinear footprint, and the footprints
+// of neighbouring pixels, share cache lines whichever way a triangle runs
+// across the texture.
+class Texture {
+public:
+    // Copies width x height row-major texels and builds the mip chain.
+    // Fails, leaving the texture empty, unless both sides are powers of two.
+    bool create(int width, int height, const Color* pixels) {
+        levels.clear();
+        if (!isPowerOfTwo(width) || !isPowerOfTwo(height) || !pixels) return false;
+        
+        levels.emplace_back(width, height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) levels[0].at(x, y) = pixels[(size_t)y * width + x];
+        }
+        
+        while (levels.back().width > 1 || levels.back().height > 1) {
+            const Level& source = levels.back();
+            Level level(std::max(1, source.width / 2), std::max(1, source.height / 2));
+            for (int y = 0; y < level.height; ++y) {
+                int y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+                for (int x = 0; x < level.width; ++x) {
+                    int x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                    const Color& a = source.at(x0, y0);
+                    const Color& b = source.at(x1, y0);
+                    const Color& c = source.at(x0, y1);
+                    const Color& d = source.at(x1, y1);
+                    level.at(x, y) = Color((uint8_t)((a.r + b.r + c.r + d.r + 2) >> 2), (uint8_t)((a.g + b.g + c.g + d.g + 2) >> 2),
+                                           (uint8_t)((a.b + b.b + c.b + d.b + 2) >> 2), (uint8_t)((a.a + b.a + c.a + d.a + 2) >> 2));
+                }
             }
+            levels.push_back(std::move(level));
         }
+        return true;
     }
+    
+    bool isEmpty() const { return levels.empty(); }
+    int getWidth() const { return levels.empty() ? 0 : levels[0].width; }
+    int getHeight() const { return levels.empty() ? 0 : levels[0].height; }
+    int getLevelCount() const { return (int)levels.size(); }
+    
+    // Texel of a level, with wrapped coordinates
+    Color getTexel(int level, int x, int y) const {
+        const Level& l = levels[level];
+        return l.at(x & (l.width - 1), y & (l.height - 1));
+    }
+    
+    // Mip level for a pixel whose footprint, the larger squared length of its
+    // screen-space UV derivatives measured in level 0 texels, is footprint:
+    // the level where the pixel spans closest to one texel. That is
+    // round(log2(footprint) / 2), which the float exponent gives exactly.
+    int selectLevel(float footprint) const {
+        uint32_t bits;
+        memcpy(&bits, &footprint, sizeof(bits));
+        if ((int32_t)bits <= 0) return 0;
+        int exponent = (int)((bits >> 23) & 0xFF) - 127;
+        return std::min(std::max((exponent + 1) >> 1, 0), (int)levels.size() - 1);
+    }
+    
+    // Bilinearly filtered colors at four texture coordinates, each from its
+    // own mip level, with wrap addressing. Weights are quantized to 1/256 and
+    // blended in integers, so results do not depend on the instruction set.
+    void sample4(const float* u, const float* v, const int* level, Color* out) const {
+        alignas(16) int32_t x0[4], y0[4];
+        int32_t widthMask[4], heightMask[4];
+        float widthScale[4], heightScale[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            const Level& l = levels[level[lane]];
+            widthMask[lane] = l.width - 1;
+            heightMask[lane] = l.height - 1;
+            widthScale[lane] = (float)(l.width << 8);
+            heightScale[lane] = (float)(l.height << 8);
+        }
+
+#if RS_SIMD_WIDTH > 1
+        // Coordinates in 24.8 fixed point relative to texel centers
+        __m128i fixedX = toFixed(_mm_loadu_ps(u), _mm_loadu_ps(widthScale));
+        __m128i fixedY = toFixed(_mm_loadu_ps(v), _mm_loadu_ps(heightScale));
+        const __m128i fraction = _mm_set1_epi32(0xFF);
+        _mm_store_si128(reinterpret_cast<__m128i*>(x0), _mm_srai_epi32(fixedX, 8));
+        _mm_store_si128(reinterpret_cast<__m128i*>(y0), _mm_srai_epi32(fixedY, 8));
+        __m128i weightX = _mm_and_si128(fixedX, fraction);
+        __m128i weightY = _mm_and_si128(fixedY, fraction);
+#else
+        int32_t fx[4], fy[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            int32_t fixedX = toFixed(u[lane], widthScale[lane]);
+            int32_t fixedY = toFixed(v[lane], heightScale[lane]);
+            x0[lane] = fixedX >> 8;
+            y0[lane] = fixedY >> 8;
+            fx[lane] = fixedX & 0xFF;
+            fy[lane] = fixedY & 0xFF;
+        }
+#endif
+        
+        alignas(16) Color texels[4][4]; // top left, top right, bottom left, bottom right per lane
+        for (int lane = 0; lane < 4; ++lane) {
+            const Level& l = levels[level[lane]];
+            int left = x0[lane] & widthMask[lane], right = (x0[lane] + 1) & widthMask[lane];
+            int top = y0[lane] & heightMask[lane], bottom = (y0[lane] + 1) & heightMask[lane];
+            texels[0][lane] = l.texels[l.mortonX[left] | l.mortonY[top]];
+            texels[1][lane] = l.texels[l.mortonX[right] | l.mortonY[top]];
+            texels[2][lane] = l.texels[l.mortonX[left] | l.mortonY[bottom]];
+            texels[3][lane] = l.texels[l.mortonX[right] | l.mortonY[bottom]];
+        }
+
+#if RS_SIMD_WIDTH > 1
+        // Eight 16-bit channels per register: lanes 0-1 in lo, 2-3 in hi
+        const __m128i zero = _mm_setzero_si128();
+        __m128i corners[4];
+        for (int i = 0; i < 4; ++i) corners[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(texels[i]));
+        __m128i blended[2];
+        for (int half = 0; half < 2; ++half) {
+            __m128i wx = spreadWeights(half ? _mm_unpackhi_epi32(weightX, weightX) : _mm_unpacklo_epi32(weightX, weightX));
+            __m128i wy = spreadWeights(half ? _mm_unpackhi_epi32(weightY, weightY) : _mm_unpacklo_epi32(weightY, weightY));
+            __m128i c[4];
+            for (int i = 0; i < 4; ++i) c[i] = half ? _mm_unpackhi_epi8(corners[i], zero) : _mm_unpacklo_epi8(corners[i], zero);
+            blended[half] = lerp(lerp(c[0], c[1], wx), lerp(c[2], c[3], wx), wy);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(blended[0], blended[1]));
+#else
+        for (int lane = 0; lane < 4; ++lane) {
+            const uint8_t* c[4];
+            for (int i = 0; i < 4; ++i) c[i] = &texels[i][lane].r;
+            uint8_t* result = &out[lane].r;
+            for (int channel = 0; channel < 4; ++channel) {
+                int top = lerp(c[0][channel], c[1][channel], fx[lane]);
+                int bottom = lerp(c[2][channel], c[3][channel], fx[lane]);
+                result[channel] = (uint8_t)lerp(top, bottom, fy[lane]);
+            }
+        }
+#endif
+    }
+
+private:
+    // One mip level; texel (x, y) is stored at mortonX[x] | mortonY[y]. The
+    // bits of the shorter side interleave with the longer side's low bits,
+    // and the longer side's remaining bits sit above them.
+    struct Level {
+        int width, height;
+        std::vector<Color> texels;
+        std::vector<uint32_t> mortonX, mortonY;
+        
+        Level(int w, int h) : width(w), height(h), texels((size_t)w * h), mortonX(w), mortonY(h) {
+            int sharedBits = 0;
+            while ((2 << sharedBits) <= std::min(w, h)) ++sharedBits;
+            for (int x = 0; x < w; ++x) mortonX[x] = spreadBits(x, sharedBits, 0);
+            for (int y = 0; y < h; ++y) mortonY[y] = spreadBits(y, sharedBits, 1);
+        }
+        
+        Color& at(int x, int y) { return texels[mortonX[x] | mortonY[y]]; }
+        const Color& at(int x, int y) const { return texels[mortonX[x] | mortonY[y]]; }
+        
+        static uint32_t spreadBits(uint32_t value, int sharedBits, int shift) {
+            uint32_t result = (value >> sharedBits) << (2 * sharedBits);
+            for (int bit = 0; bit < sharedBits; ++bit) result |= ((value >> bit) & 1u) << (2 * bit + shift);
+            return result;
+        }
+    };
+    
+    std::vector<Level> levels;
+    
+    // Texture coordinates beyond this magnitude have no sub-texel precision
+    // left and sample at 0, as do NaNs
+    static constexpr float maxCoordinate = 1048576.0f;
+    
+    static bool isPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+    
+    static int lerp(int a, int b, int weight) { return (a * (256 - weight) + b * weight + 128) >> 8; }
+
+#if RS_SIMD_WIDTH > 1
+    // Floor of each lane; SSE2 only truncates
+    static __m128i floorToInt(__m128 x) {
+        __m128i truncated = _mm_cvttps_epi32(x);
+        return _mm_add_epi32(truncated, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), x)));
+    }
+    
+    static __m128i toFixed(__m128 t, __m128 scale) {
+        __m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), t);
+        t = _mm_and_ps(t, _mm_cmplt_ps(magnitude, _mm_set1_ps(maxCoordinate)));
+        __m128 wrapped = _mm_sub_ps(t, _mm_cvtepi32_ps(floorToInt(t)));
+        return floorToInt(_mm_sub_ps(_mm_mul_ps(wrapped, scale), _mm_set1_ps(128.0f)));
+    }
+    
+    // Spreads the weights of two pixels, duplicated into 32-bit lanes 0-1
+    // and 2-3, over the four 16-bit channels of each pixel
+    static __m128i spreadWeights(__m128i pair) {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pair, 0xA0), 0xA0);
+    }
+    
+    // Every intermediate fits in an unsigned 16-bit channel
+    static __m128i lerp(__m128i a, __m128i b, __m128i weight) {
+        __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a, inverse), _mm_mullo_epi16(b, weight)), _mm_set1_epi16(128));
+        return _mm_srli_epi16(sum, 8);
+    }
+#else
+    static int32_t toFixed(float t, float scale) {
+        if (!(std::fabs(t) < maxCoordinate)) t = 0.0f;
+        float wrapped = t - std::floor(t);
+        float scaled = wrapped * scale;
+        return (int32_t)std::floor(scaled - 128.0f);
+    }
+#endif
 };
 
-// Vertex with position and color
+// Vertex with position, color, texture coordinates and normal
 struct Vertex {
     vector3 position;
     Color color;
-    Vertex(const vector3& pos = vector3(), const Color& col = Color()) : position(pos), color(col) {}
+    float u, v;
+    vector3 normal;
+    Vertex(const vector3& pos = vector3(), const Color& col = Color(), float texU = 0.0f, float texV = 0.0f,
+           const vector3& n = vector3()) : position(pos), color(col), u(texU), v(texV), normal(n) {}
 };
 
 // Triangle face
@@ -128,124 +765,2667 @@ struct Triangle {
         : v0(a), v1(b), v2(c), color(col) {}
 };
 
+// Tightens a sphere around points already bounded by box: centered on the
+// box, with the radius of the farthest point
+template <typename PointAt>
+inline BoundingSphere computeBoundingSphere(const BoundingBox& box, size_t count, PointAt pointAt) {
+    if (box.isEmpty()) return BoundingSphere();
+    
+    vector3 center = box.getCenter();
+    float radiusSq = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        radiusSq = std::max(radiusSq, (pointAt(i) - center).lengthSquared());
+    }
+    return BoundingSphere(center, std::sqrt(radiusSq));
+}
+
 // 3D Mesh
+// Bounds are cached and recomputed on first use after a change. Code that
+// edits triangles directly must call markBoundsDirty afterwards.
 struct Mesh {
     std::vector<Triangle> triangles;
     Color baseColor;
+    const Texture* texture = nullptr; // sampled at the vertex UVs and modulated by the vertex colors; not owned
     
     Mesh(const Color& col = Color()) : baseColor(col) {}
     
     void addTriangle(const Vertex& a, const Vertex& b, const Vertex& c) {
         triangles.emplace_back(a, b, c, baseColor);
+        boundsDirty = true;
     }
     
     void addTriangle(const Triangle& tri) {
         triangles.push_back(tri);
+        boundsDirty = true;
+    }
+    
+    void markBoundsDirty() { boundsDirty = true; }
+    
+    const BoundingBox& getBounds() const {
+        if (boundsDirty) updateBounds();
+        return bounds;
+    }
+    
+    const BoundingSphere& getBoundingSphere() const {
+        if (boundsDirty) updateBounds();
+        return sphere;
     }
-};
 
-// Main rendering system
-class RenderSystem {
 private:
-    FrameBuffer& frameBuffer;
-    Camera& camera;
+    mutable BoundingBox bounds;
+    mutable BoundingSphere sphere;
+    mutable bool boundsDirty = true;
     
-    float edgeFunction(const vector3& a, const vector3& b, const vector3& c) {
-        return (c.x - a.x) * (b.y - a.y) - (c.y - a.y) * (b.x - a.x);
+    const vector3& vertexAt(size_t i) const {
+        const Triangle& tri = triangles[i / 3];
+        return i % 3 == 0 ? tri.v0.position : (i % 3 == 1 ? tri.v1.position : tri.v2.position);
     }
     
-    Color interpolateColor(const Color& c0, const Color& c1, const Color& c2, float alpha, float beta, float gamma) {
-        return Color(
-            (uint8_t)(alpha * c0.r + beta * c1.r + gamma * c2.r),
-            (uint8_t)(alpha * c0.g + beta * c1.g + gamma * c2.g),
-            (uint8_t)(alpha * c0.b + beta * c1.b + gamma * c2.b),
-            (uint8_t)(alpha * c0.a + beta * c1.a + gamma * c2.a)
-        );
+    void updateBounds() const {
+        bounds = BoundingBox();
+        for (const auto& tri : triangles) {
+            bounds.expand(tri.v0.position);
+            bounds.expand(tri.v1.position);
+            bounds.expand(tri.v2.position);
+        }
+        sphere = computeBoundingSphere(bounds, triangles.size() * 3, [&](size_t i) { return vertexAt(i); });
+        boundsDirty = false;
     }
+};
+
+// Read-only view of indexed geometry owned elsewhere, such as by an
+// IndexedMesh or a memory-mapped mesh file. The renderer reads indexed
+// meshes through it, so either kind is drawn in place.
+struct IndexedMeshView {
+    const float* positionX = nullptr;
+    const float* positionY = nullptr;
+    const float* positionZ = nullptr;
+    const Color* colors = nullptr;
+    const float* texU = nullptr;
+    const float* texV = nullptr;
+    const float* normalX = nullptr;
+    const float* normalY = nullptr;
+    const float* normalZ = nullptr;
+    const uint16_t* indices16 = nullptr;
+    const uint32_t* indices32 = nullptr; // takes precedence when set
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    BoundingBox bounds;
+    BoundingSphere sphere;
+    const Texture* texture = nullptr;
     
-    vector3 projectToScreen(const vector3& worldPoint) {
-        vector3 cameraSpace = camera.worldToCameraSpace(worldPoint);
-        if (cameraSpace.z <= 0) return vector3(-1, -1, -1);
-        
-        float screenX = (cameraSpace.x / (camera.tanHalfFovX * cameraSpace.z) + 1.0f) * 0.5f * frameBuffer.width;
-        float screenY = (1.0f - (cameraSpace.y / (camera.tanHalfFovY * cameraSpace.z))) * 0.5f * frameBuffer.height;
-        return vector3(screenX, screenY, cameraSpace.z);
+    size_t getVertexCount() const { return vertexCount; }
+    size_t getTriangleCount() const { return triangleCount; }
+    
+    uint32_t getIndex(size_t i) const { return indices32 ? indices32[i] : indices16[i]; }
+    
+    vector3 getPosition(uint32_t vertex) const {
+        return vector3(positionX[vertex], positionY[vertex], positionZ[vertex]);
     }
+    
+    const BoundingBox& getBounds() const { return bounds; }
+    const BoundingSphere& getBoundingSphere() const { return sphere; }
+};
 
-public:
-    RenderSystem(FrameBuffer& fb, Camera& cam) : frameBuffer(fb), camera(cam) {}
+// Indexed 3D mesh with structure-of-arrays vertex streams. Indices start as
+// 16-bit and are promoted to 32-bit once the mesh outgrows them.
+struct IndexedMesh {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<Color> colors;
+    std::vector<float> texU, texV;
+    std::vector<float> normalX, normalY, normalZ;
+    std::vector<uint16_t> indices16;
+    std::vector<uint32_t> indices32;
+    bool wideIndices = false;
+    Color baseColor;
+    const Texture* texture = nullptr; // as for Mesh
     
-    void rasterizeTriangle(const Triangle& tri) {
-        vector3 screen0 = projectToScreen(tri.v0.position);
-        vector3 screen1 = projectToScreen(tri.v1.position);
-        vector3 screen2 = projectToScreen(tri.v2.position);
-        
-        if (screen0.z <= 0 || screen1.z <= 0 || screen2.z <= 0) return;
-        
-        int minX = std::max(0, (int)std::floor(std::min(screen0.x, std::min(screen1.x, screen2.x))));
-        int maxX = std::min(frameBuffer.width - 1, (int)std::ceil(std::max(screen0.x, std::max(screen1.x, screen2.x))));
-        int minY = std::max(0, (int)std::floor(std::min(screen0.y, std::min(screen1.y, screen2.y))));
-        int maxY = std::min(frameBuffer.height - 1, (int)std::ceil(std::max(screen0.y, std::max(screen1.y, screen2.y))));
+    IndexedMesh(const Color& col = Color()) : baseColor(col) {}
+    
+    size_t getVertexCount() const { return positionX.size(); }
+    size_t getIndexCount() const { return wideIndices ? indices32.size() : indices16.size(); }
+    size_t getTriangleCount() const { return getIndexCount() / 3; }
+    bool usesWideIndices() const { return wideIndices; }
+    
+    uint32_t getIndex(size_t i) const { return wideIndices ? indices32[i] : indices16[i]; }
+    
+    vector3 getPosition(uint32_t vertex) const {
+        return vector3(positionX[vertex], positionY[vertex], positionZ[vertex]);
+    }
+    
+    vector3 getNormal(uint32_t vertex) const {
+        return vector3(normalX[vertex], normalY[vertex], normalZ[vertex]);
+    }
+    
+    Vertex getVertex(uint32_t vertex) const {
+        return Vertex(getPosition(vertex), colors[vertex], texU[vertex], texV[vertex], getNormal(vertex));
+    }
+    
+    uint32_t addVertex(const Vertex& v) {
+        boundsDirty = true;
+        positionX.push_back(v.position.x);
+        positionY.push_back(v.position.y);
+        positionZ.push_back(v.position.z);
+        colors.push_back(v.color);
+        texU.push_back(v.u);
+        texV.push_back(v.v);
+        normalX.push_back(v.normal.x);
+        normalY.push_back(v.normal.y);
+        normalZ.push_back(v.normal.z);
         
-        for (int y = minY; y <= maxY; ++y) {
-            for (int x = minX; x <= maxX; ++x) {
-                vector3 pixelPos(x + 0.5f, y + 0.5f, 0);
-                
-                float alpha = edgeFunction(screen1, screen2, pixelPos);
-                float beta = edgeFunction(screen2, screen0, pixelPos);
-                float gamma = edgeFunction(screen0, screen1, pixelPos);
-                
-                if (alpha >= 0 && beta >= 0 && gamma >= 0) {
-                    float totalArea = alpha + beta + gamma;
-                    alpha /= totalArea;
-                    beta /= totalArea;
-                    gamma /= totalArea;
-                    
-                    float depth = alpha * screen0.z + beta * screen1.z + gamma * screen2.z;
-                    Color pixelColor = interpolateColor(tri.v0.color, tri.v1.color, tri.v2.color, alpha, beta, gamma);
-                    frameBuffer.setPixel(x, y, pixelColor, depth);
-                }
-            }
+        uint32_t index = (uint32_t)positionX.size() - 1;
+        if (!wideIndices && index > 0xFFFF) widenIndices();
+        return index;
+    }
+    
+    void addTriangle(uint32_t a, uint32_t b, uint32_t c) {
+        if (wideIndices) {
+            indices32.push_back(a);
+            indices32.push_back(b);
+            indices32.push_back(c);
+        }
+        else {
+            indices16.push_back((uint16_t)a);
+            indices16.push_back((uint16_t)b);
+            indices16.push_back((uint16_t)c);
         }
     }
     
-    void renderMesh(const Mesh& mesh) {
+    void reserve(size_t vertexCount, size_t triangleCount) {
+        positionX.reserve(vertexCount);
+        positionY.reserve(vertexCount);
+        positionZ.reserve(vertexCount);
+        colors.reserve(vertexCount);
+        texU.reserve(vertexCount);
+        texV.reserve(vertexCount);
+        normalX.reserve(vertexCount);
+        normalY.reserve(vertexCount);
+        normalZ.reserve(vertexCount);
+        if (!wideIndices && vertexCount > 0x10000) widenIndices();
+        if (wideIndices) indices32.reserve(triangleCount * 3);
+        else indices16.reserve(triangleCount * 3);
+    }
+    
+    void markBoundsDirty() { boundsDirty = true; }
+    
+    const BoundingBox& getBounds() const {
+        if (boundsDirty) updateBounds();
+        return bounds;
+    }
+    
+    const BoundingSphere& getBoundingSphere() const {
+        if (boundsDirty) updateBounds();
+        return sphere;
+    }
+    
+    // View of the current streams; adding vertices or triangles invalidates it
+    IndexedMeshView getView() const {
+        IndexedMeshView view;
+        view.positionX = positionX.data();
+        view.positionY = positionY.data();
+        view.positionZ = positionZ.data();
+        view.colors = colors.data();
+        view.texU = texU.data();
+        view.texV = texV.data();
+        view.normalX = normalX.data();
+        view.normalY = normalY.data();
+        view.normalZ = normalZ.data();
+        if (wideIndices) view.indices32 = indices32.data();
+        else view.indices16 = indices16.data();
+        view.vertexCount = getVertexCount();
+        view.triangleCount = getTriangleCount();
+        view.bounds = getBounds();
+        view.sphere = getBoundingSphere();
+        view.texture = texture;
+        return view;
+    }
+    
+    // Builds an indexed mesh from a triangle soup, welding vertices whose
+    // attributes all match bit for bit
+    static IndexedMesh fromMesh(const Mesh& mesh) {
+        IndexedMesh indexed(mesh.baseColor);
+        indexed.texture = mesh.texture;
+        std::unordered_map<std::string, uint32_t> vertexLookup;
+        vertexLookup.reserve(mesh.triangles.size() * 3);
+        
+        auto weld = [&](const Vertex& v) {
+            const float attributes[8] = { v.position.x, v.position.y, v.position.z, v.u, v.v, v.normal.x, v.normal.y, v.normal.z };
+            char key[sizeof(attributes) + sizeof(Color)];
+            memcpy(key, attributes, sizeof(attributes));
+            memcpy(key + sizeof(attributes), &v.color, sizeof(Color));
+            
+            auto found = vertexLookup.emplace(std::string(key, sizeof(key)), 0);
+            if (found.second) found.first->second = indexed.addVertex(v);
+            return found.first->second;
+        };
+        
         for (const auto& tri : mesh.triangles) {
-            rasterizeTriangle(tri);
+            uint32_t a = weld(tri.v0);
+            uint32_t b = weld(tri.v1);
+            uint32_t c = weld(tri.v2);
+            indexed.addTriangle(a, b, c);
         }
+        return indexed;
     }
+
+private:
+    mutable BoundingBox bounds;
+    mutable BoundingSphere sphere;
+    mutable bool boundsDirty = true;
     
-    void renderScene(const std::vector<Mesh>& meshes) {
-        for (const auto& mesh : meshes) {
-            renderMesh(mesh);
-        }
+    // Moves the triangles added so far to the 32-bit index stream
+    void widenIndices() {
+        indices32.assign(indices16.begin(), indices16.end());
+        indices16.clear();
+        indices16.shrink_to_fit();
+        wideIndices = true;
+    }
+    
+    void updateBounds() const {
+        bounds = BoundingBox();
+        for (size_t i = 0; i < getVertexCount(); ++i) bounds.expand(getPosition((uint32_t)i));
+        sphere = computeBoundingSphere(bounds, getVertexCount(), [&](size_t i) { return getPosition((uint32_t)i); });
+        boundsDirty = false;
     }
 };
 
-// Mesh generators for common shapes
-namespace MeshGenerators {
-    Mesh createCube(float size = 1.0f, const Color& color = Color(255, 0, 0)) {
-        Mesh cube(color);
-        float halfSize = size * 0.5f;
+// Chain of progressively simplified versions of a mesh, built once at load
+// time by quadric error metric edge collapse. Level 0 is the source mesh;
+// each level stores its geometric error, the RMS distance to the source
+// surface, which select() projects to pixels to pick the coarsest level that
+// still looks right at the current distance.
+class MeshLOD {
+public:
+    // Builds up to maxLevels levels, each with about reduction times the
+    // triangles of the one before, stopping at minTriangles or when no
+    // further edge can be collapsed without folding the surface
+    void build(const Mesh& source, int maxLevels = 6, float reduction = 0.5f, size_t minTriangles = 8) {
+        levels.clear();
+        levelErrors.clear();
+        levels.push_back(source);
+        levelErrors.push_back(0.0f);
+        currentLevel = 0;
+        if (maxLevels < 2 || source.triangles.size() <= minTriangles) return;
         
-        std::vector<Vertex> vertices = {
-            Vertex(vector3(-halfSize, -halfSize, halfSize), color),
-            Vertex(vector3(halfSize, -halfSize, halfSize), color),
-            Vertex(vector3(halfSize, halfSize, halfSize), color),
-            Vertex(vector3(-halfSize, halfSize, halfSize), color),
-            Vertex(vector3(-halfSize, -halfSize, -halfSize), color),
-            Vertex(vector3(-halfSize, halfSize, -halfSize), color),
-            Vertex(vector3(halfSize, halfSize, -halfSize), color),
-            Vertex(vector3(halfSize, -halfSize, -halfSize), color),
-            Vertex(vector3(-halfSize, halfSize, -halfSize), color),
-            Vertex(vector3(-halfSize, halfSize, halfSize), color),
-            Vertex(vector3(halfSize, halfSize, halfSize), color),
-            Vertex(vector3(halfSize, halfSize, -halfSize), color),
-            Vertex(vector3(-halfSize, -halfSize, -halfSize), color),
-            Vertex(vector3(halfSize, -halfSize, -halfSize), color),
-            Vertex(vector3(halfSize, -halfSize, halfSize), color),
-            Vertex(vector3(-halfSize, -halfSize, halfSize), color),
-            Vertex(vector3(halfSize, -halfSize, -halfSize), color),
+        Simplifier simplifier(IndexedMesh::fromMesh(source));
+        size_t target = source.triangles.size();
+        while ((int)levels.size() < maxLevels) {
+            target = std::max(minTriangles, (size_t)(target * reduction));
+            bool reached = simplifier.collapseTo(target);
+            if (simplifier.getTriangleCount() >= levels.back().triangles.size()) break;
+            
+            levels.push_back(simplifier.extract(source.baseColor));
+            levels.back().texture = source.texture;
+            levelErrors.push_back(simplifier.getError());
+            if (!reached || target == minTriangles) break;
+        }
+    }
+    
+    size_t getLevelCount() const { return levels.size(); }
+    const Mesh& getLevel(size_t level) const { return levels[level]; }
+    float getLevelError(size_t level) const { return levelErrors[level]; }
+    size_t getCurrentLevel() const { return currentLevel; }
+    
+    // Largest projected error, in pixels, a selected level may have
+    void setPixelError(float pixels) { pixelError = pixels; }
+    
+    // Fraction of pixelError by which the projected error has to overshoot
+    // before switching to a finer level, or undershoot before switching to
+    // a coarser one, so objects near a threshold do not flicker
+    void setHysteresis(float fraction) { hysteresis = fraction; }
+    
+    // Picks the level for this frame from the distance between the camera
+    // and the nearest point of the bounding sphere
+    size_t selectLevel(const Camera& camera, int viewportWidth) {
+        if (levels.empty()) return 0;
+        
+        const BoundingSphere& sphere = levels[0].getBoundingSphere();
+        float distance = std::sqrt((sphere.center - camera.position).lengthSquared()) - sphere.radius;
+        float pixelsPerUnit = viewportWidth * 0.5f / (std::max(distance, camera.nearZ) * camera.tanHalfFovX);
+        
+        size_t level = std::min(currentLevel, levels.size() - 1);
+        while (level > 0 && levelErrors[level] * pixelsPerUnit > pixelError * (1.0f + hysteresis)) --level;
+        while (level + 1 < levels.size() && levelErrors[level + 1] * pixelsPerUnit < pixelError * (1.0f - hysteresis)) ++level;
+        currentLevel = level;
+        return level;
+    }
+    
+    const Mesh& select(const Camera& camera, int viewportWidth) {
+        return levels[selectLevel(camera, viewportWidth)];
+    }
+
+private:
+    // Symmetric 4x4 error quadric of a set of planes, with the total weight
+    // of the planes so the error can be reported as a distance
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0, c = 0;
+        double weight = 0;
+        
+        // Plane n.p + d = 0 with unit normal n
+        void addPlane(const vector3& n, float d, double w) {
+            a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+            a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+            b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+            c += w * (double)d * d;
+            weight += w;
+        }
+        
+        void add(const Quadric& q) {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+            weight += q.weight;
+        }
+        
+        // Weighted sum of squared distances from p to the planes
+        double evaluate(const vector3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                     + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return std::max(e, 0.0);
+        }
+    };
+    
+    // Half-edge collapse simplifier: a vertex is merged into a neighbor,
+    // so surviving vertices keep their position and attributes. Boundary
+    // edges are held in place by perpendicular planes, and vertices on an
+    // attribute seam (another vertex at the same position) never move,
+    // which keeps the two sides of the seam from cracking apart.
+    class Simplifier {
+    public:
+        explicit Simplifier(IndexedMesh source) : mesh(std::move(source)) {
+            size_t vertexCount = mesh.getVertexCount();
+            size_t triangleCount = mesh.getTriangleCount();
+            indices.resize(triangleCount * 3);
+            for (size_t i = 0; i < indices.size(); ++i) indices[i] = mesh.getIndex(i);
+            triangleAlive.assign(triangleCount, true);
+            liveTriangles = triangleCount;
+            
+            quadrics.resize(vertexCount);
+            vertexTriangles.resize(vertexCount);
+            vertexStamp.assign(vertexCount, 0);
+            vertexRemoved.assign(vertexCount, false);
+            vertexLocked.assign(vertexCount, false);
+            
+            std::unordered_map<uint64_t, uint32_t> edgeUses;
+            for (uint32_t t = 0; t < triangleCount; ++t) {
+                const uint32_t* tri = &indices[t * 3];
+                vector3 p0 = mesh.getPosition(tri[0]), p1 = mesh.getPosition(tri[1]), p2 = mesh.getPosition(tri[2]);
+                vector3 normal = (p1 - p0).cross(p2 - p0);
+                float area = std::sqrt(normal.lengthSquared()) * 0.5f;
+                normal = normal.normalize();
+                for (int i = 0; i < 3; ++i) {
+                    quadrics[tri[i]].addPlane(normal, -normal.dot(p0), area);
+                    vertexTriangles[tri[i]].push_back(t);
+                    ++edgeUses[edgeKey(tri[i], tri[(i + 1) % 3])];
+                }
+            }
+            
+            // Boundary edges get a plane through the edge, perpendicular to
+            // their face, weighted heavily enough to keep the outline
+            for (uint32_t t = 0; t < triangleCount; ++t) {
+                const uint32_t* tri = &indices[t * 3];
+                vector3 p0 = mesh.getPosition(tri[0]), p1 = mesh.getPosition(tri[1]), p2 = mesh.getPosition(tri[2]);
+                vector3 normal = (p1 - p0).cross(p2 - p0).normalize();
+                for (int i = 0; i < 3; ++i) {
+                    uint32_t a = tri[i], b = tri[(i + 1) % 3];
+                    if (edgeUses[edgeKey(a, b)] != 1) continue;
+                    vector3 edge = mesh.getPosition(b) - mesh.getPosition(a);
+                    vector3 side = edge.cross(normal).normalize();
+                    double w = boundaryWeight * edge.lengthSquared();
+                    quadrics[a].addPlane(side, -side.dot(mesh.getPosition(a)), w);
+                    quadrics[b].addPlane(side, -side.dot(mesh.getPosition(a)), w);
+                }
+            }
+            
+            std::unordered_map<std::string, uint32_t> positionUses;
+            for (uint32_t v = 0; v < vertexCount; ++v) ++positionUses[positionKey(v)];
+            for (uint32_t v = 0; v < vertexCount; ++v) vertexLocked[v] = positionUses[positionKey(v)] > 1;
+            
+            for (uint32_t v = 0; v < vertexCount; ++v) pushEdges(v);
+        }
+        
+        size_t getTriangleCount() const { return liveTriangles; }
+        float getError() const { return maxError; }
+        
+        // Collapses the cheapest edges until at most target triangles are
+        // left; false when it ran out of collapses first
+        bool collapseTo(size_t target) {
+            while (liveTriangles > target) {
+                if (candidates.empty()) return false;
+                Collapse collapse = candidates.top();
+                candidates.pop();
+                if (vertexRemoved[collapse.from] || vertexRemoved[collapse.to]) continue;
+                if (collapse.fromStamp != vertexStamp[collapse.from] || collapse.toStamp != vertexStamp[collapse.to]) continue;
+                if (foldsSurface(collapse.from, collapse.to)) continue;
+                
+                apply(collapse);
+            }
+            return true;
+        }
+        
+        Mesh extract(const Color& baseColor) const {
+            Mesh result(baseColor);
+            for (size_t t = 0; t < triangleAlive.size(); ++t) {
+                if (!triangleAlive[t]) continue;
+                const uint32_t* tri = &indices[t * 3];
+                result.addTriangle(mesh.getVertex(tri[0]), mesh.getVertex(tri[1]), mesh.getVertex(tri[2]));
+            }
+            return result;
+        }
+
+    private:
+        struct Collapse {
+            float cost;
+            uint32_t from, to;
+            uint32_t fromStamp, toStamp;
+            
+            bool operator<(const Collapse& other) const { return cost > other.cost; }
+        };
+        
+        static constexpr double boundaryWeight = 10.0;
+        
+        IndexedMesh mesh;
+        std::vector<uint32_t> indices;
+        std::vector<bool> triangleAlive;
+        size_t liveTriangles = 0;
+        std::vector<Quadric> quadrics;
+        std::vector<std::vector<uint32_t>> vertexTriangles;
+        std::vector<uint32_t> vertexStamp;
+        std::vector<bool> vertexRemoved, vertexLocked;
+        std::priority_queue<Collapse> candidates;
+        float maxError = 0.0f;
+        
+        static uint64_t edgeKey(uint32_t a, uint32_t b) {
+            return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+        }
+        
+        std::string positionKey(uint32_t v) const {
+            const float p[3] = { mesh.positionX[v], mesh.positionY[v], mesh.positionZ[v] };
+            return std::string(reinterpret_cast<const char*>(p), sizeof(p));
+        }
+        
+        // RMS distance from the merged vertex to the planes of both quadrics
+        float collapseError(uint32_t from, uint32_t to) const {
+            Quadric q = quadrics[from];
+            q.add(quadrics[to]);
+            return q.weight > 0 ? (float)std::sqrt(q.evaluate(mesh.getPosition(to)) / q.weight) : 0.0f;
+        }
+        
+        // Queues the cheaper direction of every edge around v
+        void pushEdges(uint32_t v) {
+            for (uint32_t t : vertexTriangles[v]) {
+                if (!triangleAlive[t]) continue;
+                for (int i = 0; i < 3; ++i) {
+                    uint32_t n = indices[t * 3 + i];
+                    if (n == v) continue;
+                    
+                    Collapse best = { FLT_MAX, 0, 0, 0, 0 };
+                    if (!vertexLocked[v]) best = { collapseError(v, n), v, n, vertexStamp[v], vertexStamp[n] };
+                    if (!vertexLocked[n]) {
+                        float cost = collapseError(n, v);
+                        if (cost < best.cost) best = { cost, n, v, vertexStamp[n], vertexStamp[v] };
+                    }
+                    if (best.cost < FLT_MAX) candidates.push(best);
+                }
+            }
+        }
+        
+        // True when moving from onto to would flip or flatten one of the
+        // triangles that survive the collapse
+        bool foldsSurface(uint32_t from, uint32_t to) const {
+            vector3 target = mesh.getPosition(to);
+            for (uint32_t t : vertexTriangles[from]) {
+                if (!triangleAlive[t]) continue;
+                const uint32_t* tri = &indices[t * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+                
+                vector3 p[3], moved[3];
+                for (int i = 0; i < 3; ++i) {
+                    p[i] = mesh.getPosition(tri[i]);
+                    moved[i] = tri[i] == from ? target : p[i];
+                }
+                vector3 before = (p[1] - p[0]).cross(p[2] - p[0]);
+                vector3 after = (moved[1] - moved[0]).cross(moved[2] - moved[0]);
+                if (before.dot(after) <= 0.0f) return true;
+            }
+            return false;
+        }
+        
+        void apply(const Collapse& collapse) {
+            uint32_t from = collapse.from, to = collapse.to;
+            maxError = std::max(maxError, collapse.cost);
+            quadrics[to].add(quadrics[from]);
+            vertexRemoved[from] = true;
+            ++vertexStamp[to];
+            
+            for (uint32_t t : vertexTriangles[from]) {
+                if (!triangleAlive[t]) continue;
+                uint32_t* tri = &indices[t * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                    triangleAlive[t] = false;
+                    --liveTriangles;
+                    continue;
+                }
+                for (int i = 0; i < 3; ++i) {
+                    if (tri[i] == from) tri[i] = to;
+                }
+                vertexTriangles[to].push_back(t);
+            }
+            vertexTriangles[from].clear();
+            
+            // Drop dead triangles from the survivor's list before requeueing
+            auto& list = vertexTriangles[to];
+            list.erase(std::remove_if(list.begin(), list.end(), [&](uint32_t t) { return !triangleAlive[t]; }), list.end());
+            pushEdges(to);
+        }
+    };
+    
+    std::vector<Mesh> levels;
+    std::vector<float> levelErrors;
+    size_t currentLevel = 0;
+    float pixelError = 1.0f;
+    float hysteresis = 0.25f;
+};
+
+// Bounding volume hierarchy over scene items, typically one per mesh.
+// Built top-down with median splits; when items move, update() refits the
+// boxes on the path to the root, and rebuild() restores split quality after
+// large changes.
+class SceneBVH {
+private:
+    struct Node {
+        BoundingBox bounds;
+        int32_t left = -1, right = -1, parent = -1;
+        uint32_t firstItem = 0, itemCount = 0; // every subtree owns a contiguous item range
+        
+        bool isLeaf() const { return left < 0; }
+    };
+    
+    static const uint32_t maxLeafItems = 4;
+    
+    std::vector<Node> nodes;
+    std::vector<uint32_t> items;
+    std::vector<BoundingBox> itemBounds;
+    std::vector<int32_t> itemLeaf;
+    mutable std::vector<std::pair<int32_t, uint32_t>> traversalStack;
+    
+    static float axisOf(const vector3& v, int axis) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+    
+    int32_t buildNode(int32_t parent, uint32_t begin, uint32_t end) {
+        int32_t index = (int32_t)nodes.size();
+        nodes.emplace_back();
+        nodes[index].parent = parent;
+        nodes[index].firstItem = begin;
+        nodes[index].itemCount = end - begin;
+        
+        BoundingBox bounds, centroidBounds;
+        for (uint32_t i = begin; i < end; ++i) {
+            bounds.expand(itemBounds[items[i]]);
+            centroidBounds.expand(itemBounds[items[i]].getCenter());
+        }
+        nodes[index].bounds = bounds;
+        if (end - begin <= maxLeafItems) {
+            for (uint32_t i = begin; i < end; ++i) itemLeaf[items[i]] = index;
+            return index;
+        }
+        
+        vector3 size = centroidBounds.max - centroidBounds.min;
+        int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+        uint32_t mid = begin + (end - begin) / 2;
+        std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, [&](uint32_t a, uint32_t b) {
+            return axisOf(itemBounds[a].getCenter(), axis) < axisOf(itemBounds[b].getCenter(), axis);
+        });
+        
+        int32_t left = buildNode(index, begin, mid);
+        int32_t right = buildNode(index, mid, end);
+        nodes[index].left = left;
+        nodes[index].right = right;
+        return index;
+    }
+    
+    BoundingBox computeNodeBounds(const Node& node) const {
+        BoundingBox bounds;
+        if (node.isLeaf()) {
+            for (uint32_t i = 0; i < node.itemCount; ++i) bounds.expand(itemBounds[items[node.firstItem + i]]);
+        }
+        else {
+            bounds.expand(nodes[node.left].bounds);
+            bounds.expand(nodes[node.right].bounds);
+        }
+        return bounds;
+    }
+
+public:
+    void build(const std::vector<BoundingBox>& bounds) {
+        itemBounds = bounds;
+        rebuild();
+    }
+    
+    template <typename MeshType>
+    void build(const std::vector<MeshType>& meshes) {
+        itemBounds.clear();
+        itemBounds.reserve(meshes.size());
+        for (const auto& mesh : meshes) itemBounds.push_back(mesh.getBounds());
+        rebuild();
+    }
+    
+    // Rebuilds the hierarchy from the current item bounds
+    void rebuild() {
+        uint32_t count = (uint32_t)itemBounds.size();
+        nodes.clear();
+        items.resize(count);
+        itemLeaf.assign(count, -1);
+        for (uint32_t i = 0; i < count; ++i) items[i] = i;
+        if (count > 0) buildNode(-1, 0, count);
+    }
+    
+    // Moves one item and refits its ancestors, stopping as soon as a box no
+    // longer changes
+    void update(uint32_t item, const BoundingBox& bounds) {
+        itemBounds[item] = bounds;
+        for (int32_t index = itemLeaf[item]; index >= 0; index = nodes[index].parent) {
+            BoundingBox refitted = computeNodeBounds(nodes[index]);
+            if (refitted == nodes[index].bounds) break;
+            nodes[index].bounds = refitted;
+        }
+    }
+    
+    // Refits every node bottom-up; children always follow their parent
+    void refit() {
+        for (size_t i = nodes.size(); i-- > 0;) nodes[i].bounds = computeNodeBounds(nodes[i]);
+    }
+    
+    size_t getItemCount() const { return itemBounds.size(); }
+    size_t getNodeCount() const { return nodes.size(); }
+    const BoundingBox& getItemBounds(uint32_t item) const { return itemBounds[item]; }
+    
+    // Collects the items whose boxes intersect the frustum, in ascending
+    // order. Planes a node is entirely inside are not tested again below it,
+    // and a subtree inside every plane is accepted without visiting it.
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+        visible.clear();
+        if (nodes.empty()) return;
+        
+        traversalStack.clear();
+        traversalStack.emplace_back(0, Frustum::allPlanes);
+        while (!traversalStack.empty()) {
+            int32_t index = traversalStack.back().first;
+            uint32_t planeMask = traversalStack.back().second;
+            traversalStack.pop_back();
+            
+            const Node& node = nodes[index];
+            if (node.bounds.isEmpty() || !frustum.classify(node.bounds, planeMask)) continue;
+            
+            if (planeMask == 0) {
+                visible.insert(visible.end(), items.begin() + node.firstItem, items.begin() + node.firstItem + node.itemCount);
+            }
+            else if (node.isLeaf()) {
+                for (uint32_t i = 0; i < node.itemCount; ++i) {
+                    uint32_t item = items[node.firstItem + i];
+                    uint32_t itemMask = planeMask;
+                    if (!itemBounds[item].isEmpty() && frustum.classify(itemBounds[item], itemMask)) visible.push_back(item);
+                }
+            }
+            else {
+                traversalStack.emplace_back(node.right, planeMask);
+                traversalStack.emplace_back(node.left, planeMask);
+            }
+        }
+        std::sort(visible.begin(), visible.end());
+    }
+};
+
+// Draw list sorted before rendering. Each submission carries a caller sort
+// key, typically a pass or material group, which takes precedence; meshes
+// with the same key are drawn front to back by the nearest camera depth of
+// their bounding sphere, so depth and hierarchical-Z tests reject more of
+// what follows. Submitting the same draws again reuses or repairs the
+// previous order instead of sorting from scratch.
+class RenderQueue {
+public:
+    enum class SortMethod {
+        Reused,   // previous order still sorted
+        Repaired, // previous order fixed up by insertion sort
+        Radix     // full radix sort
+    };
+    
+    struct Item {
+        const Mesh* mesh;
+        const IndexedMesh* indexedMesh;
+        uint32_t sortKey;
+        
+        bool operator==(const Item& other) const {
+            return mesh == other.mesh && indexedMesh == other.indexedMesh && sortKey == other.sortKey;
+        }
+    };
+    
+    // Starts a new list; the last sorted order is kept for reuse
+    void clear() { items.clear(); }
+    
+    void submit(const Mesh& mesh, uint32_t sortKey = 0) { items.push_back({ &mesh, nullptr, sortKey }); }
+    void submit(const IndexedMesh& mesh, uint32_t sortKey = 0) { items.push_back({ nullptr, &mesh, sortKey }); }
+    
+    size_t size() const { return items.size(); }
+    
+    // Item at a sorted position; valid after sort()
+    const Item& getItem(size_t position) const { return items[order[position]]; }
+    
+    SortMethod sort(const Camera& camera) {
+        size_t count = items.size();
+        keys.resize(count);
+        auto sortKeyOf = [&](const Item& item) {
+            const BoundingSphere& sphere = item.mesh ? item.mesh->getBoundingSphere() : item.indexedMesh->getBoundingSphere();
+            float depth = std::max(0.0f, (sphere.center - camera.position).dot(camera.forward) - std::max(sphere.radius, 0.0f));
+            uint32_t depthBits; // non-negative floats order like their bit patterns
+            memcpy(&depthBits, &depth, sizeof(depthBits));
+            return ((uint64_t)item.sortKey << 32) | depthBits;
+        };
+        
+        if (items == previousItems) {
+            size_t descents = 0;
+            for (size_t i = 0; i < count; ++i) {
+                keys[i] = sortKeyOf(items[order[i]]);
+                if (i > 0 && keys[i] < keys[i - 1]) ++descents;
+            }
+            if (descents == 0) return SortMethod::Reused;
+            if (repairOrder()) return SortMethod::Repaired;
+        }
+        else {
+            order.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                order[i] = (uint32_t)i;
+                keys[i] = sortKeyOf(items[i]);
+            }
+            previousItems = items;
+        }
+        
+        radixSort();
+        return SortMethod::Radix;
+    }
+
+private:
+    std::vector<Item> items, previousItems;
+    std::vector<uint32_t> order, scratchOrder;
+    std::vector<uint64_t> keys, scratchKeys;
+    
+    // Insertion sort over the previous order, which is cheap while only a
+    // few draws changed places; gives up once it has moved more than a few
+    // elements per item
+    bool repairOrder() {
+        size_t count = keys.size(), moves = 0, moveBudget = count * 4;
+        for (size_t i = 1; i < count; ++i) {
+            uint64_t key = keys[i];
+            uint32_t item = order[i];
+            size_t j = i;
+            for (; j > 0 && keys[j - 1] > key; --j) {
+                keys[j] = keys[j - 1];
+                order[j] = order[j - 1];
+            }
+            keys[j] = key;
+            order[j] = item;
+            
+            moves += i - j;
+            if (moves > moveBudget) return false;
+        }
+        return true;
+    }
+    
+    // Stable LSD radix sort of keys and order, one byte per pass; passes in
+    // which every key has the same byte are skipped
+    void radixSort() {
+        size_t count = keys.size();
+        uint32_t histograms[8][256] = {};
+        for (size_t i = 0; i < count; ++i) {
+            for (int pass = 0; pass < 8; ++pass) ++histograms[pass][(keys[i] >> (pass * 8)) & 0xFF];
+        }
+        
+        scratchKeys.resize(count);
+        scratchOrder.resize(count);
+        for (int pass = 0; pass < 8; ++pass) {
+            uint32_t* histogram = histograms[pass];
+            if (count == 0 || histogram[(keys[0] >> (pass * 8)) & 0xFF] == count) continue;
+            
+            uint32_t offset = 0;
+            for (int digit = 0; digit < 256; ++digit) {
+                uint32_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t destination = histogram[(keys[i] >> (pass * 8)) & 0xFF]++;
+                scratchKeys[destination] = keys[i];
+                scratchOrder[destination] = order[i];
+            }
+            keys.swap(scratchKeys);
+            order.swap(scratchOrder);
+        }
+    }
+};
+
+// Face culling applied by RenderSystem's primitive assembly
+enum class CullMode {
+    None,
+    Back,
+    Front
+};
+
+// One copy of an instanced mesh: its model-to-world transform and a tint
+// multiplied into the vertex colors; white leaves them unchanged
+struct Instance {
+    Transform transform;
+    Color color;
+    
+    Instance(const Transform& t = Transform(), const Color& tint = Color()) : transform(t), color(tint) {}
+};
+
+// Primitive assembly counters
+struct PrimitiveStats {
+    uint64_t submitted = 0;         // triangles handed to the renderer
+    uint64_t culledBackface = 0;    // rejected by the winding test
+    uint64_t culledDegenerate = 0;  // zero area after snapping
+    uint64_t culledOffscreen = 0;   // behind the near plane or outside the viewport
+    uint64_t clipped = 0;           // split against the near plane or guard band
+    uint64_t emitted = 0;           // screen triangles sent to the rasterizer
+    uint64_t culledMeshes = 0;      // meshes rejected by their bounds before assembly
+    uint64_t occludedMeshes = 0;    // meshes hidden behind the hierarchical depth buffer
+    
+    void add(const PrimitiveStats& other) {
+        culledMeshes += other.culledMeshes;
+        occludedMeshes += other.occludedMeshes;
+        submitted += other.submitted;
+        culledBackface += other.culledBackface;
+        culledDegenerate += other.culledDegenerate;
+        culledOffscreen += other.culledOffscreen;
+        clipped += other.clipped;
+        emitted += other.emitted;
+    }
+};
+
+// Wall-clock seconds spent per pipeline stage, accumulated across draws
+// like PrimitiveStats. Untiled draws interleave assembly and rasterization
+// triangle by triangle, so they charge both to raster.
+struct StageTimings {
+    double cull = 0;      // frustum, hierarchy and occlusion tests on mesh bounds
+    double assembly = 0;  // vertex transform, clipping and triangle setup
+    double binning = 0;   // sorting screen triangles into tiles
+    double raster = 0;    // coverage, depth test and shading, or triangle IDs in visibility-buffer mode
+    double resolve = 0;   // shading the visibility buffer
+    
+    void add(const StageTimings& other) {
+        cull += other.cull;
+        assembly += other.assembly;
+        binning += other.binning;
+        raster += other.raster;
+        resolve += other.resolve;
+    }
+};
+
+// Main rendering system
+class RenderSystem {
+private:
+    FrameBuffer& frameBuffer;
+    Camera& camera;
+    
+    // Vertex attributes interpolated across triangles, in this order:
+    // color (r, g, b, a in 0..255), texture coordinates (u, v), normal (x, y, z)
+    static const int attributeCount = 9;
+    enum { AttrRed, AttrGreen, AttrBlue, AttrAlpha, AttrU, AttrV, AttrNormalX, AttrNormalY, AttrNormalZ };
+    
+    // Triangle after projection, with its screen-clamped bounding box
+    struct ProjectedTriangle {
+        vector3 s0, s1, s2;
+        float attributes[3][attributeCount];
+        int minX, minY, maxX, maxY;
+        const Texture* texture;
+    };
+    
+    // Vertex after the camera transform, with the clip planes it lies outside
+    struct TransformedVertex {
+        vector3 cameraSpace;
+        vector3 screen;
+        uint32_t outcode;
+    };
+    
+    // Camera-space vertex carried through the clipper
+    struct ClipVertex {
+        vector3 position;
+        float attributes[attributeCount];
+    };
+    
+    // Triangle of a soup mesh queued for tiled assembly, with its mesh's texture
+    struct TriangleRef {
+        const Triangle* triangle;
+        const Texture* texture;
+    };
+    
+    // Visible instance of an instanced draw, with its model-to-camera transform
+    struct InstanceView {
+        Transform modelView;
+        const Instance* instance;
+    };
+    
+    // Outcome of screen-space triangle setup, used for the assembly counters
+    enum class SetupResult { Emitted, Backface, Degenerate, Offscreen };
+    
+    static const int clipPlaneCount = 5;
+    static const int maxClipVertices = 3 + clipPlaneCount;
+    
+    bool simdEnabled = true;
+    bool occlusionCulling = true;
+    CullMode cullMode = CullMode::Back;
+    PrimitiveStats primitiveStats;
+    bool stageTiming = false;
+    StageTimings stageTimings;
+    
+    // Camera-space planes (nx, ny, nz, d) for the near plane and the four
+    // guard-band sides, and the world-space view frustum for mesh culling,
+    // both refreshed whenever a draw starts
+    float clipPlanes[clipPlaneCount][4];
+    Frustum frustum;
+    Transform viewTransform;
+    std::vector<uint32_t> visibleItems;
+    std::vector<const Mesh*> selectedLevels;
+    
+    // Tiled mode state, reused across frames to avoid reallocating bins
+    bool tiledMode = false;
+    int tileSize = 64;
+    std::unique_ptr<WorkerPool> workerPool;
+    std::vector<TriangleRef> triangleRefs;
+    std::vector<ProjectedTriangle> projectedTriangles;
+    std::vector<std::vector<ProjectedTriangle>> batchTriangles;
+    std::vector<PrimitiveStats> batchStats;
+    std::vector<std::vector<uint32_t>> tileBins;
+    std::vector<InstanceView> instanceViews;
+    
+    // Post-transform cache: every vertex of the indexed mesh being drawn,
+    // transformed once per frame and shared by its triangles
+    std::vector<TransformedVertex> postTransform;
+    
+    static void loadAttributes(const Vertex& v, float* out) {
+        out[AttrRed] = v.color.r;
+        out[AttrGreen] = v.color.g;
+        out[AttrBlue] = v.color.b;
+        out[AttrAlpha] = v.color.a;
+        out[AttrU] = v.u;
+        out[AttrV] = v.v;
+        out[AttrNormalX] = v.normal.x;
+        out[AttrNormalY] = v.normal.y;
+        out[AttrNormalZ] = v.normal.z;
+    }
+    
+    static void loadAttributes(const IndexedMeshView& mesh, uint32_t vertex, float* out) {
+        const Color& color = mesh.colors[vertex];
+        out[AttrRed] = color.r;
+        out[AttrGreen] = color.g;
+        out[AttrBlue] = color.b;
+        out[AttrAlpha] = color.a;
+        out[AttrU] = mesh.texU[vertex];
+        out[AttrV] = mesh.texV[vertex];
+        out[AttrNormalX] = mesh.normalX[vertex];
+        out[AttrNormalY] = mesh.normalY[vertex];
+        out[AttrNormalZ] = mesh.normalZ[vertex];
+    }
+    
+    // Tints the color and rotates the normal of one vertex's attributes
+    static void applyInstance(const Instance& instance, float* attributes) {
+        attributes[AttrRed] = attributes[AttrRed] * instance.color.r / 255.0f;
+        attributes[AttrGreen] = attributes[AttrGreen] * instance.color.g / 255.0f;
+        attributes[AttrBlue] = attributes[AttrBlue] * instance.color.b / 255.0f;
+        attributes[AttrAlpha] = attributes[AttrAlpha] * instance.color.a / 255.0f;
+        vector3 normal = instance.transform.transformDirection(
+            vector3(attributes[AttrNormalX], attributes[AttrNormalY], attributes[AttrNormalZ]));
+        attributes[AttrNormalX] = normal.x;
+        attributes[AttrNormalY] = normal.y;
+        attributes[AttrNormalZ] = normal.z;
+    }
+    
+    using StageClock = std::chrono::steady_clock;
+    
+    StageClock::time_point startStage() const {
+        return stageTiming ? StageClock::now() : StageClock::time_point();
+    }
+    
+    // Charges the time since mark to stage and restarts mark; does nothing
+    // unless stage timing is enabled
+    void chargeStage(double& stage, StageClock::time_point& mark) {
+        if (!stageTiming) return;
+        StageClock::time_point now = StageClock::now();
+        stage += std::chrono::duration<double>(now - mark).count();
+        mark = now;
+    }
+    
+    void updateViewConstants() {
+        frustum = Frustum(camera);
+        viewTransform = camera.getViewTransform();
+        
+        float bandX = 2.0f * RS_CLIP_GUARD_BAND / frameBuffer.width;
+        float bandY = 2.0f * RS_CLIP_GUARD_BAND / frameBuffer.height;
+        const float planes[clipPlaneCount][4] = {
+            { 0, 0, 1, -camera.nearZ },                                   // z >= near
+            { 1, 0, (bandX + 1.0f) * camera.tanHalfFovX, 0 },             // screen x >= -guard band
+            { -1, 0, (bandX - 1.0f) * camera.tanHalfFovX, 0 },            // screen x <= guard band
+            { 0, -1, (bandY + 1.0f) * camera.tanHalfFovY, 0 },            // screen y >= -guard band
+            { 0, 1, (bandY - 1.0f) * camera.tanHalfFovY, 0 }              // screen y <= guard band
+        };
+        memcpy(clipPlanes, planes, sizeof(clipPlanes));
+    }
+    
+    float planeDistance(int plane, const vector3& p) const {
+        const float* n = clipPlanes[plane];
+        return n[0] * p.x + n[1] * p.y + n[2] * p.z + n[3];
+    }
+    
+    vector3 cameraToScreen(const vector3& cameraSpace) const {
+        float screenX = (cameraSpace.x / (camera.tanHalfFovX * cameraSpace.z) + 1.0f) * 0.5f * frameBuffer.width;
+        float screenY = (1.0f - (cameraSpace.y / (camera.tanHalfFovY * cameraSpace.z))) * 0.5f * frameBuffer.height;
+        return vector3(screenX, screenY, cameraSpace.z);
+    }
+    
+    TransformedVertex transformPoint(const vector3& worldPoint) const {
+        return classifyPoint(camera.worldToCameraSpace(worldPoint));
+    }
+    
+    // Instanced vertices go from model to camera space in one step
+    TransformedVertex transformPoint(const Transform& modelView, const vector3& modelPoint) const {
+        return classifyPoint(modelView.transformPoint(modelPoint));
+    }
+    
+    TransformedVertex classifyPoint(const vector3& cameraSpace) const {
+        TransformedVertex v;
+        v.cameraSpace = cameraSpace;
+        v.outcode = 0;
+        for (int plane = 0; plane < clipPlaneCount; ++plane) {
+            if (planeDistance(plane, v.cameraSpace) < 0) v.outcode |= 1u << plane;
+        }
+        v.screen = v.outcode ? vector3(-1, -1, -1) : cameraToScreen(v.cameraSpace);
+        return v;
+    }
+    
+    static void snapToSubpixel(vector3& s) {
+        const float scale = (float)(1 << RS_SUBPIXEL_BITS);
+        s.x = std::nearbyint(s.x * scale) / scale;
+        s.y = std::nearbyint(s.y * scale) / scale;
+    }
+    
+    static bool insideGuardBand(const vector3& s) {
+        return fabsf(s.x) <= RS_GUARD_BAND && fabsf(s.y) <= RS_GUARD_BAND;
+    }
+    
+    // Snaps a screen-space triangle, applies the cull mode and clamps its
+    // bounding box. Triangles that survive always have positive area, which
+    // is the winding the rasterizer fills; front faces are the ones that are
+    // counter-clockwise on screen.
+    SetupResult setupScreenTriangle(const vector3& s0, const vector3& s1, const vector3& s2,
+                                    const float* a0, const float* a1, const float* a2, ProjectedTriangle& out) const {
+        out.s0 = s0;
+        out.s1 = s1;
+        out.s2 = s2;
+        memcpy(out.attributes[0], a0, sizeof(out.attributes[0]));
+        memcpy(out.attributes[1], a1, sizeof(out.attributes[1]));
+        memcpy(out.attributes[2], a2, sizeof(out.attributes[2]));
+        
+        // Clipping keeps vertices inside the guard band up to float rounding
+        if (!insideGuardBand(out.s0) || !insideGuardBand(out.s1) || !insideGuardBand(out.s2)) return SetupResult::Offscreen;
+        
+        // Snap to the sub-pixel grid so coverage is decided on exact integers
+        snapToSubpixel(out.s0);
+        snapToSubpixel(out.s1);
+        snapToSubpixel(out.s2);
+        
+        const float scale = (float)(1 << RS_SUBPIXEL_BITS);
+        int64_t x0 = (int64_t)(out.s0.x * scale), y0 = (int64_t)(out.s0.y * scale);
+        int64_t area = ((int64_t)(out.s2.x * scale) - x0) * ((int64_t)(out.s1.y * scale) - y0) -
+                       ((int64_t)(out.s2.y * scale) - y0) * ((int64_t)(out.s1.x * scale) - x0);
+        if (area == 0) return SetupResult::Degenerate;
+        
+        bool frontFacing = area > 0;
+        if ((cullMode == CullMode::Back && !frontFacing) || (cullMode == CullMode::Front && frontFacing)) {
+            return SetupResult::Backface;
+        }
+        if (area < 0) {
+            std::swap(out.s1, out.s2);
+            std::swap(out.attributes[1], out.attributes[2]);
+        }
+        
+        out.minX = std::max(0, (int)std::floor(std::min(out.s0.x, std::min(out.s1.x, out.s2.x))));
+        out.maxX = std::min(frameBuffer.width - 1, (int)std::ceil(std::max(out.s0.x, std::max(out.s1.x, out.s2.x))));
+        out.minY = std::max(0, (int)std::floor(std::min(out.s0.y, std::min(out.s1.y, out.s2.y))));
+        out.maxY = std::min(frameBuffer.height - 1, (int)std::ceil(std::max(out.s0.y, std::max(out.s1.y, out.s2.y))));
+        
+        if (out.minX > out.maxX || out.minY > out.maxY) return SetupResult::Offscreen;
+        return SetupResult::Emitted;
+    }
+    
+    static ClipVertex toClipVertex(const TransformedVertex& v, const float* attributes) {
+        ClipVertex clipVertex;
+        clipVertex.position = v.cameraSpace;
+        memcpy(clipVertex.attributes, attributes, sizeof(clipVertex.attributes));
+        return clipVertex;
+    }
+    
+    // Sutherland-Hodgman step: keeps the part of a convex polygon on the
+    // inside of one clip plane. Returns the new vertex count.
+    int clipPolygon(int plane, const ClipVertex* in, int count, ClipVertex* out) const {
+        int outCount = 0;
+        for (int i = 0; i < count; ++i) {
+            const ClipVertex& a = in[i];
+            const ClipVertex& b = in[(i + 1) % count];
+            float da = planeDistance(plane, a.position);
+            float db = planeDistance(plane, b.position);
+            
+            if (da >= 0) out[outCount++] = a;
+            if ((da >= 0) != (db >= 0)) {
+                float t = da / (da - db);
+                ClipVertex& v = out[outCount++];
+                v.position = a.position + (b.position - a.position) * t;
+                for (int k = 0; k < attributeCount; ++k) {
+                    v.attributes[k] = a.attributes[k] + (b.attributes[k] - a.attributes[k]) * t;
+                }
+            }
+        }
+        return outCount;
+    }
+    
+    // Primitive assembly: trivially rejects triangles outside one clip plane,
+    // passes triangles inside the guard band straight to setup (the
+    // rasterizer scissors anything that is only partly off screen) and splits
+    // the rest against the near plane and the guard band.
+    template <typename Emit>
+    void assemblePrimitive(const TransformedVertex& v0, const TransformedVertex& v1, const TransformedVertex& v2,
+                           const float* a0, const float* a1, const float* a2, const Texture* texture,
+                           PrimitiveStats& stats, Emit&& emit) const {
+        ++stats.submitted;
+        if (v0.outcode & v1.outcode & v2.outcode) {
+            ++stats.culledOffscreen;
+            return;
+        }
+        
+        ProjectedTriangle pt;
+        pt.texture = texture;
+        uint32_t crossed = v0.outcode | v1.outcode | v2.outcode;
+        if (crossed == 0) {
+            SetupResult result = setupScreenTriangle(v0.screen, v1.screen, v2.screen, a0, a1, a2, pt);
+            countSetupResult(result, stats);
+            if (result == SetupResult::Emitted) emit(pt);
+            return;
+        }
+        
+        ++stats.clipped;
+        ClipVertex polygon[2][maxClipVertices + 1];
+        polygon[0][0] = toClipVertex(v0, a0);
+        polygon[0][1] = toClipVertex(v1, a1);
+        polygon[0][2] = toClipVertex(v2, a2);
+        int count = 3, current = 0;
+        for (int plane = 0; plane < clipPlaneCount && count >= 3; ++plane) {
+            if (!(crossed & (1u << plane))) continue;
+            count = clipPolygon(plane, polygon[current], count, polygon[current ^ 1]);
+            current ^= 1;
+        }
+        if (count < 3) {
+            ++stats.culledOffscreen;
+            return;
+        }
+        
+        const ClipVertex* clipped = polygon[current];
+        vector3 screen[maxClipVertices + 1];
+        for (int i = 0; i < count; ++i) screen[i] = cameraToScreen(clipped[i].position);
+        
+        // Fan triangles share the polygon's winding; a primitive that emits
+        // nothing is counted under the reason its first piece was dropped
+        SetupResult firstResult = SetupResult::Offscreen;
+        bool emitted = false;
+        for (int i = 1; i + 1 < count; ++i) {
+            SetupResult result = setupScreenTriangle(screen[0], screen[i], screen[i + 1],
+                                                     clipped[0].attributes, clipped[i].attributes, clipped[i + 1].attributes, pt);
+            if (i == 1) firstResult = result;
+            if (result == SetupResult::Emitted) {
+                ++stats.emitted;
+                emitted = true;
+                emit(pt);
+            }
+        }
+        if (!emitted) countSetupResult(firstResult, stats);
+    }
+    
+    static void countSetupResult(SetupResult result, PrimitiveStats& stats) {
+        switch (result) {
+            case SetupResult::Emitted: ++stats.emitted; break;
+            case SetupResult::Backface: ++stats.culledBackface; break;
+            case SetupResult::Degenerate: ++stats.culledDegenerate; break;
+            case SetupResult::Offscreen: ++stats.culledOffscreen; break;
+        }
+    }
+    
+    template <typename Emit>
+    void assembleTriangle(const Triangle& tri, const Texture* texture, PrimitiveStats& stats, Emit&& emit) const {
+        float attributes[3][attributeCount];
+        loadAttributes(tri.v0, attributes[0]);
+        loadAttributes(tri.v1, attributes[1]);
+        loadAttributes(tri.v2, attributes[2]);
+        assemblePrimitive(transformPoint(tri.v0.position), transformPoint(tri.v1.position), transformPoint(tri.v2.position),
+                          attributes[0], attributes[1], attributes[2], texture, stats, emit);
+    }
+    
+    template <typename Emit>
+    void assembleTriangle(const Triangle& tri, const Texture* texture, const InstanceView& view, PrimitiveStats& stats, Emit&& emit) const {
+        float attributes[3][attributeCount];
+        loadAttributes(tri.v0, attributes[0]);
+        loadAttributes(tri.v1, attributes[1]);
+        loadAttributes(tri.v2, attributes[2]);
+        for (int i = 0; i < 3; ++i) applyInstance(*view.instance, attributes[i]);
+        assemblePrimitive(transformPoint(view.modelView, tri.v0.position), transformPoint(view.modelView, tri.v1.position),
+                          transformPoint(view.modelView, tri.v2.position), attributes[0], attributes[1], attributes[2], texture, stats, emit);
+    }
+    
+    // Fills postTransform[begin, end) from the mesh's vertex streams
+    void transformVertices(const IndexedMeshView& mesh, size_t begin, size_t end) {
+        const float* px = mesh.positionX;
+        const float* py = mesh.positionY;
+        const float* pz = mesh.positionZ;
+        TransformedVertex* out = postTransform.data();
+        
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = transformPoint(vector3(px[i], py[i], pz[i]));
+        }
+    }
+    
+    // Fills postTransform[begin, end) for the instances in views, where entry
+    // i * vertexCount + v holds vertex v of instance i; one range can span
+    // several instances, so the transform is batched across them
+    void transformInstanceVertices(const IndexedMeshView& mesh, const InstanceView* views, size_t begin, size_t end) {
+        const float* px = mesh.positionX;
+        const float* py = mesh.positionY;
+        const float* pz = mesh.positionZ;
+        TransformedVertex* out = postTransform.data();
+        size_t vertexCount = mesh.getVertexCount();
+        
+        for (size_t i = begin; i < end;) {
+            size_t instance = i / vertexCount;
+            size_t runEnd = std::min(end, (instance + 1) * vertexCount);
+            const Transform& modelView = views[instance].modelView;
+            for (size_t v = i - instance * vertexCount; i < runEnd; ++i, ++v) {
+                out[i] = transformPoint(modelView, vector3(px[v], py[v], pz[v]));
+            }
+        }
+    }
+    
+    // Assembles one triangle from already transformed vertices; instance,
+    // when given, tints and rotates the vertex attributes
+    template <typename Emit>
+    void assembleIndexed(const IndexedMeshView& mesh, size_t triangle, const TransformedVertex* vertices, const Instance* instance,
+                         PrimitiveStats& stats, Emit&& emit) const {
+        uint32_t a = mesh.getIndex(triangle * 3);
+        uint32_t b = mesh.getIndex(triangle * 3 + 1);
+        uint32_t c = mesh.getIndex(triangle * 3 + 2);
+        float attributes[3][attributeCount];
+        loadAttributes(mesh, a, attributes[0]);
+        loadAttributes(mesh, b, attributes[1]);
+        loadAttributes(mesh, c, attributes[2]);
+        if (instance) {
+            for (int i = 0; i < 3; ++i) applyInstance(*instance, attributes[i]);
+        }
+        assemblePrimitive(vertices[a], vertices[b], vertices[c],
+                          attributes[0], attributes[1], attributes[2], mesh.texture, stats, emit);
+    }
+    
+    // Fixed-point edge equation over RS_SUBPIXEL_BITS sub-pixel coordinates.
+    // The top-left fill rule is applied through bias, so pixels on an edge
+    // shared by two triangles are drawn exactly once.
+    struct FixedEdge {
+        int64_t a, b, c;
+        int64_t bias; // 0 on top and left edges, -1 elsewhere
+        
+        void setup(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+            a = (int64_t)y1 - y0;
+            b = (int64_t)x0 - x1;
+            c = -(x0 * a + y0 * b);
+            
+            bool topLeft = a > 0 || (a == 0 && b > 0);
+            bias = topLeft ? 0 : -1;
+        }
+        
+        int64_t at(int64_t x, int64_t y) const { return a * x + b * y + c; }
+        
+        bool covers(int64_t x, int64_t y) const { return at(x, y) + bias >= 0; }
+    };
+    
+    // Screen-space plane of a quantity interpolated across a triangle,
+    // expressed over the fixed-point edge values E0..E2:
+    //   value = E0 * vertex[0] + E1 * vertex[1] + E2 * vertex[2]
+    // Kernels evaluate it once per block row from the exact edge values at
+    // the block column, then add lane multiples of stepX, its d/dx per pixel.
+    // Every kernel and tile split rounds the same way, and nothing cancels
+    // far from the origin. stepY, the d/dy per pixel, feeds mip selection.
+    struct AttributePlane {
+        float vertex[3];
+        float stepX, stepY;
+        
+        float rowValue(float e0, float e1, float e2) const { return e0 * vertex[0] + e1 * vertex[1] + e2 * vertex[2]; }
+    };
+    
+    // Per-triangle constants shared by the scalar and SIMD kernels. Coverage
+    // is decided on the fixed-point edges. Interpolation is perspective
+    // correct: 1/z and every attribute over z are screen-linear, so each
+    // pixel takes depth z = 1 / (1/z) and multiplies the attributes by it.
+    struct RasterSetup {
+        FixedEdge edges[3];
+        AttributePlane inverseDepth;
+        AttributePlane attributes[attributeCount];
+        float z0, z1, z2;
+        float occlusionZ; // nearest vertex depth, pulled in by hiZTolerance
+        int minX, minY, maxX, maxY;
+        const Texture* texture;
+        uint32_t visibilityId; // nonzero: store this ID in the visibility buffer instead of shading
+    };
+    
+    // Visibility-buffer mode: the triangles drawn since the last resolve,
+    // where triangle ID i is entry i - 1, and their setups for the resolve
+    bool visibilityMode = false;
+    std::vector<ProjectedTriangle> visibilityTriangles;
+    std::vector<RasterSetup> visibilitySetups;
+    
+    // Interpolated depth can round a few ulps below the nearest vertex, so
+    // hierarchical depth tests compare against a slightly closer value and
+    // never reject a pixel that would have passed the depth test
+    static constexpr float hiZTolerance = 1.0f - 1.0f / 65536.0f;
+    
+    // Builds the fixed-point edges of the part of the triangle inside the
+    // inclusive clip rectangle; false when nothing is left to rasterize
+    bool setupRaster(const ProjectedTriangle& pt, int clipMinX, int clipMinY, int clipMaxX, int clipMaxY, RasterSetup& rs) const {
+        rs.minX = std::max(pt.minX, clipMinX);
+        rs.maxX = std::min(pt.maxX, clipMaxX);
+        rs.minY = std::max(pt.minY, clipMinY);
+        rs.maxY = std::min(pt.maxY, clipMaxY);
+        if (rs.minX > rs.maxX || rs.minY > rs.maxY) return false;
+        
+        rs.z0 = pt.s0.z;
+        rs.z1 = pt.s1.z;
+        rs.z2 = pt.s2.z;
+        rs.occlusionZ = std::min(rs.z0, std::min(rs.z1, rs.z2)) * hiZTolerance;
+        rs.texture = pt.texture && !pt.texture->isEmpty() ? pt.texture : nullptr;
+        rs.visibilityId = 0;
+        
+        // Snapped coordinates are exact multiples of the sub-pixel step
+        const float subpixelScale = (float)(1 << RS_SUBPIXEL_BITS);
+        int32_t x0 = (int32_t)(pt.s0.x * subpixelScale), y0 = (int32_t)(pt.s0.y * subpixelScale);
+        int32_t x1 = (int32_t)(pt.s1.x * subpixelScale), y1 = (int32_t)(pt.s1.y * subpixelScale);
+        int32_t x2 = (int32_t)(pt.s2.x * subpixelScale), y2 = (int32_t)(pt.s2.y * subpixelScale);
+        
+        int64_t area = ((int64_t)x2 - x0) * ((int64_t)y1 - y0) - ((int64_t)y2 - y0) * ((int64_t)x1 - x0);
+        if (area <= 0) return false;
+        
+        rs.edges[0].setup(x1, y1, x2, y2);
+        rs.edges[1].setup(x2, y2, x0, y0);
+        rs.edges[2].setup(x0, y0, x1, y1);
+        
+        float invArea = 1.0f / (float)area;
+        const float vertexScale[3] = { invArea / rs.z0, invArea / rs.z1, invArea / rs.z2 };
+        float edgeStepX[3], edgeStepY[3];
+        for (int i = 0; i < 3; ++i) {
+            edgeStepX[i] = (float)(rs.edges[i].a * (1 << RS_SUBPIXEL_BITS));
+            edgeStepY[i] = (float)(rs.edges[i].b * (1 << RS_SUBPIXEL_BITS));
+        }
+        
+        auto setupPlane = [&](AttributePlane& plane, float q0, float q1, float q2) {
+            plane.vertex[0] = q0 * vertexScale[0];
+            plane.vertex[1] = q1 * vertexScale[1];
+            plane.vertex[2] = q2 * vertexScale[2];
+            plane.stepX = edgeStepX[0] * plane.vertex[0] + edgeStepX[1] * plane.vertex[1] + edgeStepX[2] * plane.vertex[2];
+            plane.stepY = edgeStepY[0] * plane.vertex[0] + edgeStepY[1] * plane.vertex[1] + edgeStepY[2] * plane.vertex[2];
+        };
+        setupPlane(rs.inverseDepth, 1.0f, 1.0f, 1.0f);
+        for (int k = 0; k < attributeCount; ++k) {
+            setupPlane(rs.attributes[k], pt.attributes[0][k], pt.attributes[1][k], pt.attributes[2][k]);
+        }
+        return true;
+    }
+    
+    // Rasterizes the part of the triangle inside the inclusive clip rectangle.
+    // Per-pixel math does not depend on the clip rectangle, so splitting a
+    // triangle across tiles produces the same pixels as drawing it whole.
+    void rasterizeProjected(const ProjectedTriangle& pt, int clipMinX, int clipMinY, int clipMaxX, int clipMaxY,
+                            uint32_t visibilityId = 0) {
+        RasterSetup rs;
+        if (!setupRaster(pt, clipMinX, clipMinY, clipMaxX, clipMaxY, rs)) return;
+        rs.visibilityId = visibilityId;
+        
+        switch (frameBuffer.getFormat().depthFormat) {
+            case DepthFormat::Float32: rasterizeBlocks<DepthFloat32>(rs); break;
+            case DepthFormat::Unorm24: rasterizeBlocks<DepthUnorm24>(rs); break;
+            case DepthFormat::Unorm16: rasterizeBlocks<DepthUnorm16>(rs); break;
+        }
+    }
+    
+    template <typename Depth>
+    void rasterizeBlocks(const RasterSetup& rs) {
+#if RS_SIMD_WIDTH > 1
+        if (simdEnabled) {
+            rasterizeBlocksSimd<Depth>(rs);
+            return;
+        }
+#endif
+        rasterizeBlocksScalar<Depth>(rs);
+    }
+    
+    // Depth storage policies the kernels are instantiated with. Kernels
+    // compare and blend depth keys as floats; unorm keys are exact integers,
+    // and SIMD loads and stores convert them to and from storage.
+    struct DepthFloat32 {
+        typedef float Storage;
+        static const bool quantized = false;
+        static Storage* buffer(FrameBuffer& fb) { return fb.depthBuffer.data(); }
+        static float toKey(Storage s) { return s; }
+        static Storage fromKey(float key) { return key; }
+#if RS_SIMD_WIDTH == 8
+        static __m256 load8(const Storage* p, __m256i mask, bool) { return _mm256_maskload_ps(p, mask); }
+        static void store8(Storage* p, __m256i mask, __m256 keys, bool) { _mm256_maskstore_ps(p, mask, keys); }
+#elif RS_SIMD_WIDTH == 4
+        static __m128 load4(const Storage* p) { return _mm_loadu_ps(p); }
+        static void store4(Storage* p, __m128 keys) { _mm_storeu_ps(p, keys); }
+#endif
+    };
+    
+    struct DepthUnorm24 {
+        typedef uint32_t Storage;
+        static const bool quantized = true;
+        static Storage* buffer(FrameBuffer& fb) { return fb.depthBuffer24.data(); }
+        static float toKey(Storage s) { return (float)s; }
+        static Storage fromKey(float key) { return (Storage)key; }
+#if RS_SIMD_WIDTH == 8
+        static __m256 load8(const Storage* p, __m256i mask, bool) {
+            return _mm256_cvtepi32_ps(_mm256_maskload_epi32(reinterpret_cast<const int*>(p), mask));
+        }
+        static void store8(Storage* p, __m256i mask, __m256 keys, bool) {
+            _mm256_maskstore_epi32(reinterpret_cast<int*>(p), mask, _mm256_cvtps_epi32(keys));
+        }
+#elif RS_SIMD_WIDTH == 4
+        static __m128 load4(const Storage* p) { return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+        static void store4(Storage* p, __m128 keys) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_cvtps_epi32(keys)); }
+#endif
+    };
+    
+    // 16-bit lanes have no masked load or store, so rows that end inside the
+    // chunk fall back to per-lane access; whole rows are read and blended
+    struct DepthUnorm16 {
+        typedef uint16_t Storage;
+        static const bool quantized = true;
+        static Storage* buffer(FrameBuffer& fb) { return fb.depthBuffer16.data(); }
+        static float toKey(Storage s) { return (float)s; }
+        static Storage fromKey(float key) { return (Storage)key; }
+#if RS_SIMD_WIDTH == 8
+        static __m256 load8(const Storage* p, __m256i mask, bool fullRow) {
+            if (fullRow) return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+            
+            alignas(32) int32_t keys[8];
+            int bits = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+            for (int lane = 0; lane < 8; ++lane) keys[lane] = (bits & (1 << lane)) ? p[lane] : 0;
+            return _mm256_cvtepi32_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(keys)));
+        }
+        static void store8(Storage* p, __m256i mask, __m256 keys, bool fullRow) {
+            __m256i wide = _mm256_cvtps_epi32(keys);
+            __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(wide), _mm256_extracti128_si256(wide, 1));
+            if (fullRow) {
+                __m128i laneMask = _mm_packs_epi32(_mm256_castsi256_si128(mask), _mm256_extracti128_si256(mask, 1));
+                __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_or_si128(_mm_and_si128(laneMask, packed), _mm_andnot_si128(laneMask, old)));
+                return;
+            }
+            
+            alignas(16) uint16_t values[8];
+            _mm_store_si128(reinterpret_cast<__m128i*>(values), packed);
+            int bits = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+            for (int lane = 0; lane < 8; ++lane) {
+                if (bits & (1 << lane)) p[lane] = values[lane];
+            }
+        }
+#elif RS_SIMD_WIDTH == 4
+        static __m128 load4(const Storage* p) {
+            __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+            return _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, _mm_setzero_si128()));
+        }
+        static void store4(Storage* p, __m128 keys) {
+            // SSE2 only packs signed words, so bias into the signed range and back
+            __m128i biased = _mm_sub_epi32(_mm_cvtps_epi32(keys), _mm_set1_epi32(0x8000));
+            __m128i packed = _mm_xor_si128(_mm_packs_epi32(biased, biased), _mm_set1_epi16((short)0x8000));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), packed);
+        }
+#endif
+    };
+    
+    // Classifies an RS_BLOCK_SIZE block against the fixed-point edges using the
+    // pixel-center corner that maximizes or minimizes each edge. Returns -1 when
+    // the block is outside the triangle, otherwise a bitmask of the edges that
+    // cross it; 0 means every pixel center in the block is covered.
+    int classifyBlock(const RasterSetup& rs, int bx, int by) const {
+        const int64_t half = 1 << (RS_SUBPIXEL_BITS - 1);
+        const int64_t span = (int64_t)(RS_BLOCK_SIZE - 1) << RS_SUBPIXEL_BITS;
+        int64_t x0 = ((int64_t)bx << RS_SUBPIXEL_BITS) + half, x1 = x0 + span;
+        int64_t y0 = ((int64_t)by << RS_SUBPIXEL_BITS) + half, y1 = y0 + span;
+        
+        int partialEdges = 0;
+        for (int i = 0; i < 3; ++i) {
+            const FixedEdge& e = rs.edges[i];
+            if (!e.covers(e.a > 0 ? x1 : x0, e.b > 0 ? y1 : y0)) return -1;
+            if (!e.covers(e.a > 0 ? x0 : x1, e.b > 0 ? y0 : y1)) partialEdges |= 1 << i;
+        }
+        return partialEdges;
+    }
+    
+    // True when every pixel of the block already holds a closer depth than
+    // any point of the triangle
+    bool isBlockOccluded(const RasterSetup& rs, int bx, int by) const {
+        return occlusionCulling && rs.occlusionZ >= frameBuffer.getHiZ(bx / RS_BLOCK_SIZE, by / RS_BLOCK_SIZE);
+    }
+    
+    // Completes a pending lazy clear before the kernels touch the block.
+    // Blocks never straddle tiles, so tiled workers resolve and refresh
+    // disjoint blocks.
+    void beginBlock(int bx, int by) {
+        frameBuffer.resolveBlock(bx / RS_BLOCK_SIZE, by / RS_BLOCK_SIZE);
+    }
+    
+    void finishBlock(bool written, int bx, int by) {
+        if (written && occlusionCulling) frameBuffer.refreshHiZBlock(bx / RS_BLOCK_SIZE, by / RS_BLOCK_SIZE);
+    }
+    
+    // Shades count (up to 4) pixels of a textured triangle: samples the
+    // texture at their perspective-correct UVs and modulates colors, their
+    // packed vertex colors, by the result. Each pixel picks its mip level from
+    // its UV derivatives, which follow from the planes analytically; for u:
+    //   du/dx = z * (d(u/z)/dx - u * d(1/z)/dx)
+    // Every kernel shades through here, so textured output stays identical
+    // across kernels and tile splits.
+    static void shadeTextured(const RasterSetup& rs, const float* u, const float* v, const float* z, uint32_t* colors, int count) {
+        const Texture& texture = *rs.texture;
+        const AttributePlane& planeU = rs.attributes[AttrU];
+        const AttributePlane& planeV = rs.attributes[AttrV];
+        const float width = (float)texture.getWidth(), height = (float)texture.getHeight();
+        
+        float laneU[4] = {}, laneV[4] = {};
+        int levels[4] = {};
+        for (int lane = 0; lane < count; ++lane) {
+            laneU[lane] = u[lane];
+            laneV[lane] = v[lane];
+            float dudx = z[lane] * (planeU.stepX - u[lane] * rs.inverseDepth.stepX) * width;
+            float dvdx = z[lane] * (planeV.stepX - v[lane] * rs.inverseDepth.stepX) * height;
+            float dudy = z[lane] * (planeU.stepY - u[lane] * rs.inverseDepth.stepY) * width;
+            float dvdy = z[lane] * (planeV.stepY - v[lane] * rs.inverseDepth.stepY) * height;
+            levels[lane] = texture.selectLevel(std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy));
+        }
+        
+        Color texels[4];
+        texture.sample4(laneU, laneV, levels, texels);
+        for (int lane = 0; lane < count; ++lane) {
+            const uint8_t* texel = &texels[lane].r;
+            uint32_t shaded = 0;
+            for (int channel = 0; channel < 4; ++channel) {
+                uint32_t vertex = (colors[lane] >> (channel * 8)) & 0xFF;
+                shaded |= ((texel[channel] * (vertex + 1)) >> 8) << (channel * 8);
+            }
+            colors[lane] = shaded;
+        }
+    }
+    
+    // Plane values of one pixel row of a block, taken at the block column
+    struct RowPlanes {
+        float inverseDepth;
+        float color[4];
+        float u, v;
+    };
+    
+    static void evaluateRow(const RasterSetup& rs, int64_t blockX, int64_t fixedY, RowPlanes& row) {
+        float e0 = (float)rs.edges[0].at(blockX, fixedY);
+        float e1 = (float)rs.edges[1].at(blockX, fixedY);
+        float e2 = (float)rs.edges[2].at(blockX, fixedY);
+        row.inverseDepth = rs.inverseDepth.rowValue(e0, e1, e2);
+        for (int k = 0; k < 4; ++k) row.color[k] = rs.attributes[AttrRed + k].rowValue(e0, e1, e2);
+        row.u = rs.attributes[AttrU].rowValue(e0, e1, e2);
+        row.v = rs.attributes[AttrV].rowValue(e0, e1, e2);
+    }
+    
+    // Per-pixel shading for the scalar kernel and the visibility resolve,
+    // rounding exactly like the SIMD kernels. Textured pixels are queued and
+    // sampled four at a time, so their colors land on flush() at the latest.
+    class PixelShader {
+    public:
+        explicit PixelShader(uint32_t* colorBuffer) : colorBuffer(colorBuffer) {}
+        
+        // Pixel dx columns right of its block column, at depth z
+        void shade(const RasterSetup& rs, const RowPlanes& row, float dx, float z, int index) {
+            Color color(
+                (uint8_t)((row.color[0] + dx * rs.attributes[AttrRed].stepX) * z),
+                (uint8_t)((row.color[1] + dx * rs.attributes[AttrGreen].stepX) * z),
+                (uint8_t)((row.color[2] + dx * rs.attributes[AttrBlue].stepX) * z),
+                (uint8_t)((row.color[3] + dx * rs.attributes[AttrAlpha].stepX) * z));
+            uint32_t packed;
+            memcpy(&packed, &color, sizeof(packed));
+            if (!rs.texture) {
+                colorBuffer[index] = packed;
+                return;
+            }
+            
+            if (pending && &rs != texturedSetup) flush();
+            texturedSetup = &rs;
+            pendingIndex[pending] = index;
+            pendingU[pending] = (row.u + dx * rs.attributes[AttrU].stepX) * z;
+            pendingV[pending] = (row.v + dx * rs.attributes[AttrV].stepX) * z;
+            pendingZ[pending] = z;
+            pendingColor[pending] = packed;
+            if (++pending == 4) flush();
+        }
+        
+        void flush() {
+            if (!pending) return;
+            shadeTextured(*texturedSetup, pendingU, pendingV, pendingZ, pendingColor, pending);
+            for (int i = 0; i < pending; ++i) colorBuffer[pendingIndex[i]] = pendingColor[i];
+            pending = 0;
+        }
+
+    private:
+        uint32_t* colorBuffer;
+        const RasterSetup* texturedSetup = nullptr;
+        int pendingIndex[4];
+        float pendingU[4], pendingV[4], pendingZ[4];
+        uint32_t pendingColor[4];
+        int pending = 0;
+    };
+    
+    template <typename Depth>
+    void rasterizeBlocksScalar(const RasterSetup& rs) {
+        typename Depth::Storage* depthBuffer = Depth::buffer(frameBuffer);
+        uint32_t* visibilityBuffer = frameBuffer.visibilityBuffer.data();
+        PixelShader shader(reinterpret_cast<uint32_t*>(frameBuffer.colorBuffer.data()));
+        const int64_t half = 1 << (RS_SUBPIXEL_BITS - 1);
+        const float depthNear = frameBuffer.getFormat().depthNear;
+        const float depthScale = frameBuffer.getDepthScale(), depthMax = frameBuffer.getDepthMaxValue();
+        
+        for (int by = rs.minY & ~(RS_BLOCK_SIZE - 1); by <= rs.maxY; by += RS_BLOCK_SIZE) {
+            for (int bx = rs.minX & ~(RS_BLOCK_SIZE - 1); bx <= rs.maxX; bx += RS_BLOCK_SIZE) {
+                int partialEdges = classifyBlock(rs, bx, by);
+                if (partialEdges < 0 || isBlockOccluded(rs, bx, by)) continue;
+                
+                beginBlock(bx, by);
+                bool written = false;
+                int startX = std::max(bx, rs.minX), endX = std::min(bx + RS_BLOCK_SIZE - 1, rs.maxX);
+                int startY = std::max(by, rs.minY), endY = std::min(by + RS_BLOCK_SIZE - 1, rs.maxY);
+                int64_t blockX = ((int64_t)bx << RS_SUBPIXEL_BITS) + half;
+                
+                for (int y = startY; y <= endY; ++y) {
+                    int64_t fixedY = ((int64_t)y << RS_SUBPIXEL_BITS) + half;
+                    RowPlanes row;
+                    evaluateRow(rs, blockX, fixedY, row);
+                    int rowIndex = frameBuffer.pixelIndex(bx, y) - bx;
+                    
+                    for (int x = startX; x <= endX; ++x) {
+                        if (partialEdges) {
+                            int64_t fixedX = ((int64_t)x << RS_SUBPIXEL_BITS) + half;
+                            if (((partialEdges & 1) && !rs.edges[0].covers(fixedX, fixedY)) ||
+                                ((partialEdges & 2) && !rs.edges[1].covers(fixedX, fixedY)) ||
+                                ((partialEdges & 4) && !rs.edges[2].covers(fixedX, fixedY))) continue;
+                        }
+                        
+                        float dx = (float)(x - bx);
+                        float z = 1.0f / (row.inverseDepth + dx * rs.inverseDepth.stepX);
+                        float depth = Depth::quantized ? FrameBuffer::quantizeDepth(z, depthNear, depthScale, depthMax) : z;
+                        int index = rowIndex + x;
+                        if (depth < Depth::toKey(depthBuffer[index])) {
+                            if (rs.visibilityId) visibilityBuffer[index] = rs.visibilityId;
+                            else shader.shade(rs, row, dx, z, index);
+                            depthBuffer[index] = Depth::fromKey(depth);
+                            written = true;
+                        }
+                    }
+                }
+                finishBlock(written, bx, by);
+            }
+        }
+        shader.flush();
+    }
+
+#if RS_SIMD_WIDTH > 1
+    // Planes the SIMD kernels step across a chunk: 1/z, then the color
+    // channels, u and v over z
+    static const int chunkPlaneCount = 7;
+    
+    static const AttributePlane& chunkPlane(const RasterSetup& rs, int k) {
+        return k == 0 ? rs.inverseDepth : rs.attributes[AttrRed + k - 1];
+    }
+#endif
+
+#if RS_SIMD_WIDTH == 8
+    // Lane multiples of each chunk plane's stepX
+    static void setupChunkSteps(const RasterSetup& rs, __m256 laneOffsets, __m256* steps) {
+        for (int k = 0; k < chunkPlaneCount; ++k) steps[k] = _mm256_mul_ps(laneOffsets, _mm256_set1_ps(chunkPlane(rs, k).stepX));
+    }
+    
+    // Packed colors of the 8 pixels of a block row at depth z, from the
+    // row's edge values at the block column. Texture sampling skips the
+    // halves of the chunk without lanes in laneBits.
+    static __m256i shadeChunk(const RasterSetup& rs, const __m256* planeSteps, float rowE0, float rowE1, float rowE2, __m256 z, int laneBits) {
+        __m256i channels[4];
+        for (int k = 0; k < 4; ++k) {
+            __m256 overZ = _mm256_add_ps(_mm256_set1_ps(rs.attributes[AttrRed + k].rowValue(rowE0, rowE1, rowE2)), planeSteps[k + 1]);
+            channels[k] = _mm256_cvttps_epi32(_mm256_mul_ps(overZ, z));
+        }
+        __m256i packed = _mm256_or_si256(_mm256_or_si256(channels[0], _mm256_slli_epi32(channels[1], 8)),
+                                         _mm256_or_si256(_mm256_slli_epi32(channels[2], 16), _mm256_slli_epi32(channels[3], 24)));
+        if (!rs.texture) return packed;
+        
+        alignas(32) float u[8], v[8], laneZ[8];
+        alignas(32) uint32_t colors[8];
+        __m256 overU = _mm256_add_ps(_mm256_set1_ps(rs.attributes[AttrU].rowValue(rowE0, rowE1, rowE2)), planeSteps[5]);
+        __m256 overV = _mm256_add_ps(_mm256_set1_ps(rs.attributes[AttrV].rowValue(rowE0, rowE1, rowE2)), planeSteps[6]);
+        _mm256_store_ps(u, _mm256_mul_ps(overU, z));
+        _mm256_store_ps(v, _mm256_mul_ps(overV, z));
+        _mm256_store_ps(laneZ, z);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(colors), packed);
+        for (int half = 0; half < 8; half += 4) {
+            if (laneBits & (0xF << half)) shadeTextured(rs, u + half, v + half, laneZ + half, colors + half, 4);
+        }
+        return _mm256_load_si256(reinterpret_cast<const __m256i*>(colors));
+    }
+    
+    // AVX2 kernel: one 8-pixel chunk per block row. Fully covered blocks skip
+    // the edge tests; partial blocks test only the edges that cross them, in
+    // 32-bit lanes, which cannot overflow inside a block the edge crosses.
+    // Masked loads and stores keep lanes outside the clip rectangle untouched.
+    template <typename Depth>
+    void rasterizeBlocksSimd(const RasterSetup& rs) {
+        static_assert(sizeof(Color) == 4, "Color must pack into 32 bits");
+        static_assert(RS_BLOCK_SIZE == 8, "AVX2 kernel covers one block row per chunk");
+        typename Depth::Storage* depthBuffer = Depth::buffer(frameBuffer);
+        // The visibility pass stores triangle IDs through the color path
+        int* colorBuffer = rs.visibilityId ? reinterpret_cast<int*>(frameBuffer.visibilityBuffer.data())
+                                           : reinterpret_cast<int*>(frameBuffer.colorBuffer.data());
+        const int64_t half = 1 << (RS_SUBPIXEL_BITS - 1);
+        
+        const __m256 laneCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256 laneOffsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 depthNear = _mm256_set1_ps(frameBuffer.getFormat().depthNear);
+        const __m256 depthScale = _mm256_set1_ps(frameBuffer.getDepthScale());
+        const __m256 depthMax = _mm256_set1_ps(frameBuffer.getDepthMaxValue());
+        const __m256 firstX = _mm256_set1_ps(rs.minX + 0.5f), lastX = _mm256_set1_ps(rs.maxX + 0.5f);
+        
+        __m256i edgeLaneSteps[3], coverThreshold[3];
+        for (int i = 0; i < 3; ++i) {
+            int32_t stepX = (int32_t)(rs.edges[i].a * (1 << RS_SUBPIXEL_BITS));
+            edgeLaneSteps[i] = _mm256_mullo_epi32(laneIndex, _mm256_set1_epi32(stepX));
+            coverThreshold[i] = _mm256_set1_epi32((int32_t)(-1 - rs.edges[i].bias));
+        }
+        __m256 planeSteps[chunkPlaneCount];
+        setupChunkSteps(rs, laneOffsets, planeSteps);
+        
+        for (int by = rs.minY & ~7; by <= rs.maxY; by += 8) {
+            for (int cx = rs.minX & ~7; cx <= rs.maxX; cx += 8) {
+                int partialEdges = classifyBlock(rs, cx, by);
+                if (partialEdges < 0 || isBlockOccluded(rs, cx, by)) continue;
+                
+                beginBlock(cx, by);
+                bool written = false;
+                bool fullRow = frameBuffer.isTiled() || cx + 8 <= frameBuffer.width;
+                __m256 px = _mm256_add_ps(_mm256_set1_ps((float)cx), laneCenters);
+                __m256 rangeMask = _mm256_and_ps(_mm256_cmp_ps(px, firstX, _CMP_GE_OQ), _mm256_cmp_ps(px, lastX, _CMP_LE_OQ));
+                int64_t fixedX = ((int64_t)cx << RS_SUBPIXEL_BITS) + half;
+                int endY = std::min(by + 7, rs.maxY);
+                
+                for (int y = std::max(by, rs.minY); y <= endY; ++y) {
+                    int64_t fixedY = ((int64_t)y << RS_SUBPIXEL_BITS) + half;
+                    int64_t e0 = rs.edges[0].at(fixedX, fixedY);
+                    int64_t e1 = rs.edges[1].at(fixedX, fixedY);
+                    int64_t e2 = rs.edges[2].at(fixedX, fixedY);
+                    
+                    __m256 mask = rangeMask;
+                    if (partialEdges) {
+                        const int64_t rowEdges[3] = { e0, e1, e2 };
+                        __m256i covered = _mm256_castps_si256(rangeMask);
+                        for (int i = 0; i < 3; ++i) {
+                            if (!(partialEdges & (1 << i))) continue;
+                            __m256i e = _mm256_add_epi32(_mm256_set1_epi32((int32_t)rowEdges[i]), edgeLaneSteps[i]);
+                            covered = _mm256_and_si256(covered, _mm256_cmpgt_epi32(e, coverThreshold[i]));
+                        }
+                        mask = _mm256_castsi256_ps(covered);
+                        if (_mm256_movemask_ps(mask) == 0) continue;
+                    }
+                    
+                    float rowE0 = (float)e0, rowE1 = (float)e1, rowE2 = (float)e2;
+                    __m256 inverseDepth = _mm256_add_ps(_mm256_set1_ps(rs.inverseDepth.rowValue(rowE0, rowE1, rowE2)), planeSteps[0]);
+                    __m256 z = _mm256_div_ps(one, inverseDepth);
+                    
+                    int index = frameBuffer.pixelIndex(cx, y);
+                    __m256 depth = z;
+                    if (Depth::quantized) {
+                        __m256 scaled = _mm256_mul_ps(_mm256_sub_ps(z, depthNear), depthScale);
+                        depth = _mm256_cvtepi32_ps(_mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(scaled, _mm256_setzero_ps()), depthMax)));
+                    }
+                    __m256 oldDepth = Depth::load8(depthBuffer + index, _mm256_castps_si256(mask), fullRow);
+                    mask = _mm256_and_ps(mask, _mm256_cmp_ps(depth, oldDepth, _CMP_LT_OQ));
+                    if (_mm256_movemask_ps(mask) == 0) continue;
+                    __m256i laneMask = _mm256_castps_si256(mask);
+                    
+                    __m256i packed = rs.visibilityId ? _mm256_set1_epi32((int)rs.visibilityId)
+                                                     : shadeChunk(rs, planeSteps, rowE0, rowE1, rowE2, z, _mm256_movemask_ps(mask));
+                    
+                    _mm256_maskstore_epi32(colorBuffer + index, laneMask, packed);
+                    Depth::store8(depthBuffer + index, laneMask, depth, fullRow);
+                    written = true;
+                }
+                finishBlock(written, cx, by);
+            }
+        }
+    }
+#elif RS_SIMD_WIDTH == 4
+    static void setupChunkSteps(const RasterSetup& rs, __m128 laneOffsets, __m128* steps) {
+        for (int k = 0; k < chunkPlaneCount; ++k) steps[k] = _mm_mul_ps(laneOffsets, _mm_set1_ps(chunkPlane(rs, k).stepX));
+    }
+    
+    // Packed colors of a 4-pixel chunk at depth z, from the row's edge
+    // values at the block column and the steps of the chunk's half of it
+    static __m128i shadeChunk(const RasterSetup& rs, const __m128* planeSteps, float rowE0, float rowE1, float rowE2, __m128 z) {
+        __m128i channels[4];
+        for (int k = 0; k < 4; ++k) {
+            __m128 overZ = _mm_add_ps(_mm_set1_ps(rs.attributes[AttrRed + k].rowValue(rowE0, rowE1, rowE2)), planeSteps[k + 1]);
+            channels[k] = _mm_cvttps_epi32(_mm_mul_ps(overZ, z));
+        }
+        __m128i packed = _mm_or_si128(_mm_or_si128(channels[0], _mm_slli_epi32(channels[1], 8)),
+                                      _mm_or_si128(_mm_slli_epi32(channels[2], 16), _mm_slli_epi32(channels[3], 24)));
+        if (!rs.texture) return packed;
+        
+        alignas(16) float u[4], v[4], laneZ[4];
+        alignas(16) uint32_t colors[4];
+        __m128 overU = _mm_add_ps(_mm_set1_ps(rs.attributes[AttrU].rowValue(rowE0, rowE1, rowE2)), planeSteps[5]);
+        __m128 overV = _mm_add_ps(_mm_set1_ps(rs.attributes[AttrV].rowValue(rowE0, rowE1, rowE2)), planeSteps[6]);
+        _mm_store_ps(u, _mm_mul_ps(overU, z));
+        _mm_store_ps(v, _mm_mul_ps(overV, z));
+        _mm_store_ps(laneZ, z);
+        _mm_store_si128(reinterpret_cast<__m128i*>(colors), packed);
+        shadeTextured(rs, u, v, laneZ, colors, 4);
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(colors));
+    }
+    
+    // SSE2 kernel: two 4-pixel chunks per block row. Fully covered blocks skip
+    // the edge tests; partial blocks test only the edges that cross them, in
+    // 32-bit lanes, which cannot overflow inside a block the edge crosses.
+    // SSE2 has no cheap masked store, so chunks that straddle the clip
+    // rectangle go through a small staging buffer instead of touching pixels
+    // that may belong to another tile.
+    template <typename Depth>
+    void rasterizeBlocksSimd(const RasterSetup& rs) {
+        static_assert(sizeof(Color) == 4, "Color must pack into 32 bits");
+        static_assert(RS_BLOCK_SIZE == 8, "SSE2 kernel covers a block row in two chunks");
+        typedef typename Depth::Storage DepthStorage;
+        DepthStorage* depthBuffer = Depth::buffer(frameBuffer);
+        // The visibility pass stores triangle IDs through the color path
+        uint32_t* colorBuffer = rs.visibilityId ? frameBuffer.visibilityBuffer.data()
+                                                : reinterpret_cast<uint32_t*>(frameBuffer.colorBuffer.data());
+        const int64_t half = 1 << (RS_SUBPIXEL_BITS - 1);
+        
+        const __m128 laneCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 depthNear = _mm_set1_ps(frameBuffer.getFormat().depthNear);
+        const __m128 depthScale = _mm_set1_ps(frameBuffer.getDepthScale());
+        const __m128 depthMax = _mm_set1_ps(frameBuffer.getDepthMaxValue());
+        const __m128 firstX = _mm_set1_ps(rs.minX + 0.5f), lastX = _mm_set1_ps(rs.maxX + 0.5f);
+        
+        __m128i edgeLaneSteps[3], coverThreshold[3];
+        for (int i = 0; i < 3; ++i) {
+            int32_t stepX = (int32_t)(rs.edges[i].a * (1 << RS_SUBPIXEL_BITS));
+            edgeLaneSteps[i] = _mm_setr_epi32(0, stepX, 2 * stepX, 3 * stepX);
+            coverThreshold[i] = _mm_set1_epi32((int32_t)(-1 - rs.edges[i].bias));
+        }
+        
+        // Plane steps are taken from the block column so both chunks of a
+        // block row round exactly like the 8-wide and scalar kernels
+        __m128 planeLaneSteps[2][chunkPlaneCount];
+        setupChunkSteps(rs, _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), planeLaneSteps[0]);
+        setupChunkSteps(rs, _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f), planeLaneSteps[1]);
+        
+        alignas(16) DepthStorage stagedDepth[4];
+        alignas(16) uint32_t stagedColor[4];
+        
+        for (int by = rs.minY & ~7; by <= rs.maxY; by += 8) {
+            for (int bx = rs.minX & ~7; bx <= rs.maxX; bx += 8) {
+                int partialEdges = classifyBlock(rs, bx, by);
+                if (partialEdges < 0 || isBlockOccluded(rs, bx, by)) continue;
+                
+                beginBlock(bx, by);
+                bool written = false;
+                int endY = std::min(by + 7, rs.maxY);
+                int64_t blockX = ((int64_t)bx << RS_SUBPIXEL_BITS) + half;
+                for (int cx = std::max(bx, rs.minX & ~3); cx < bx + 8 && cx <= rs.maxX; cx += 4) {
+                    __m128 px = _mm_add_ps(_mm_set1_ps((float)cx), laneCenters);
+                    __m128 rangeMask = _mm_and_ps(_mm_cmpge_ps(px, firstX), _mm_cmple_ps(px, lastX));
+                    int64_t fixedX = ((int64_t)cx << RS_SUBPIXEL_BITS) + half;
+                    const __m128* planeSteps = planeLaneSteps[(cx - bx) >> 2];
+                    bool fullChunk = cx >= rs.minX && cx + 3 <= rs.maxX;
+                    
+                    for (int y = std::max(by, rs.minY); y <= endY; ++y) {
+                        int64_t fixedY = ((int64_t)y << RS_SUBPIXEL_BITS) + half;
+                        
+                        __m128 mask = rangeMask;
+                        if (partialEdges) {
+                            __m128i covered = _mm_castps_si128(rangeMask);
+                            for (int i = 0; i < 3; ++i) {
+                                if (!(partialEdges & (1 << i))) continue;
+                                __m128i e = _mm_add_epi32(_mm_set1_epi32((int32_t)rs.edges[i].at(fixedX, fixedY)), edgeLaneSteps[i]);
+                                covered = _mm_and_si128(covered, _mm_cmpgt_epi32(e, coverThreshold[i]));
+                            }
+                            mask = _mm_castsi128_ps(covered);
+                            if (_mm_movemask_ps(mask) == 0) continue;
+                        }
+                        
+                        float rowE0 = (float)rs.edges[0].at(blockX, fixedY);
+                        float rowE1 = (float)rs.edges[1].at(blockX, fixedY);
+                        float rowE2 = (float)rs.edges[2].at(blockX, fixedY);
+                        __m128 inverseDepth = _mm_add_ps(_mm_set1_ps(rs.inverseDepth.rowValue(rowE0, rowE1, rowE2)), planeSteps[0]);
+                        __m128 z = _mm_div_ps(one, inverseDepth);
+                        __m128 depth = z;
+                        if (Depth::quantized) {
+                            __m128 scaled = _mm_mul_ps(_mm_sub_ps(z, depthNear), depthScale);
+                            depth = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), depthMax)));
+                        }
+                        
+                        int index = frameBuffer.pixelIndex(cx, y);
+                        DepthStorage* depthTarget = depthBuffer + index;
+                        uint32_t* colorTarget = colorBuffer + index;
+                        if (!fullChunk) {
+                            for (int lane = 0; lane < 4; ++lane) {
+                                int x = cx + lane;
+                                bool inside = x >= rs.minX && x <= rs.maxX;
+                                stagedDepth[lane] = inside ? depthTarget[lane] : 0;
+                                stagedColor[lane] = inside ? colorTarget[lane] : 0;
+                            }
+                            depthTarget = stagedDepth;
+                            colorTarget = stagedColor;
+                        }
+                        
+                        __m128 oldDepth = Depth::load4(depthTarget);
+                        mask = _mm_and_ps(mask, _mm_cmplt_ps(depth, oldDepth));
+                        int writeBits = _mm_movemask_ps(mask);
+                        if (writeBits == 0) continue;
+                        written = true;
+                        
+                        __m128i packed = rs.visibilityId ? _mm_set1_epi32((int)rs.visibilityId)
+                                                         : shadeChunk(rs, planeSteps, rowE0, rowE1, rowE2, z);
+                        
+                        __m128i laneMask = _mm_castps_si128(mask);
+                        __m128i oldColor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colorTarget));
+                        __m128i newColor = _mm_or_si128(_mm_and_si128(laneMask, packed), _mm_andnot_si128(laneMask, oldColor));
+                        __m128 newDepth = _mm_or_ps(_mm_and_ps(mask, depth), _mm_andnot_ps(mask, oldDepth));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(colorTarget), newColor);
+                        Depth::store4(depthTarget, newDepth);
+                        
+                        if (!fullChunk) {
+                            for (int lane = 0; lane < 4; ++lane) {
+                                if (writeBits & (1 << lane)) {
+                                    colorBuffer[index + lane] = stagedColor[lane];
+                                    depthBuffer[index + lane] = stagedDepth[lane];
+                                }
+                            }
+                        }
+                    }
+                }
+                finishBlock(written, bx, by);
+            }
+        }
+    }
+#endif
+    
+    static const int projectBatch = 1024;
+    
+    // Runs primitive assembly over count primitives in parallel batches.
+    // Each batch collects its own triangles and counters, which are then
+    // concatenated in batch order so binning sees submission order.
+    template <typename AssembleRange>
+    void assembleBatches(int count, AssembleRange&& assembleRange) {
+        int batchCount = (count + projectBatch - 1) / projectBatch;
+        if ((int)batchTriangles.size() < batchCount) batchTriangles.resize(batchCount);
+        batchStats.assign(batchCount, PrimitiveStats());
+        
+        workerPool->parallelFor(batchCount, [&](int batch) {
+            std::vector<ProjectedTriangle>& out = batchTriangles[batch];
+            out.clear();
+            auto emit = [&](const ProjectedTriangle& pt) { out.push_back(pt); };
+            assembleRange(batch * projectBatch, std::min(count, (batch + 1) * projectBatch), batchStats[batch], emit);
+        });
+        
+        for (int batch = 0; batch < batchCount; ++batch) {
+            projectedTriangles.insert(projectedTriangles.end(), batchTriangles[batch].begin(), batchTriangles[batch].end());
+            primitiveStats.add(batchStats[batch]);
+        }
+    }
+    
+    void projectTiled(const Mesh* const* meshes, size_t meshCount) {
+        triangleRefs.clear();
+        for (size_t i = 0; i < meshCount; ++i) {
+            for (const auto& tri : meshes[i]->triangles) triangleRefs.push_back({ &tri, meshes[i]->texture });
+        }
+        
+        projectedTriangles.clear();
+        assembleBatches((int)triangleRefs.size(), [&](int begin, int end, PrimitiveStats& stats, auto& emit) {
+            for (int i = begin; i < end; ++i) assembleTriangle(*triangleRefs[i].triangle, triangleRefs[i].texture, stats, emit);
+        });
+    }
+    
+    void projectTiled(const IndexedMesh* const* meshes, size_t meshCount) {
+        projectedTriangles.clear();
+        for (size_t m = 0; m < meshCount; ++m) projectIndexedTiled(meshes[m]->getView());
+    }
+    
+    void projectTiled(const IndexedMeshView* const* meshes, size_t meshCount) {
+        projectedTriangles.clear();
+        for (size_t m = 0; m < meshCount; ++m) projectIndexedTiled(*meshes[m]);
+    }
+    
+    // Transforms the mesh's vertices once, then assembles its triangles from
+    // the post-transform cache, both in parallel
+    void projectIndexedTiled(const IndexedMeshView& mesh) {
+        int vertexCount = (int)mesh.getVertexCount();
+        postTransform.resize(vertexCount);
+        workerPool->parallelFor((vertexCount + projectBatch - 1) / projectBatch, [&](int batch) {
+            transformVertices(mesh, (size_t)batch * projectBatch, std::min<size_t>(vertexCount, (size_t)(batch + 1) * projectBatch));
+        });
+        
+        assembleBatches((int)mesh.getTriangleCount(), [&](int begin, int end, PrimitiveStats& stats, auto& emit) {
+            for (int i = begin; i < end; ++i) assembleIndexed(mesh, i, postTransform.data(), nullptr, stats, emit);
+        });
+    }
+    
+    void projectInstancesTiled(const Mesh& mesh) {
+        projectedTriangles.clear();
+        int triangleCount = (int)mesh.triangles.size();
+        assembleBatches((int)instanceViews.size() * triangleCount, [&](int begin, int end, PrimitiveStats& stats, auto& emit) {
+            for (int i = begin; i < end; ++i) {
+                assembleTriangle(mesh.triangles[i % triangleCount], mesh.texture, instanceViews[i / triangleCount], stats, emit);
+            }
+        });
+    }
+    
+    // Transforms the vertices of every visible instance in one parallel pass,
+    // then assembles all of their triangles
+    void projectInstancesTiled(const IndexedMeshView& mesh) {
+        projectedTriangles.clear();
+        size_t vertexCount = mesh.getVertexCount();
+        size_t totalVertices = instanceViews.size() * vertexCount;
+        postTransform.resize(totalVertices);
+        workerPool->parallelFor((int)((totalVertices + projectBatch - 1) / projectBatch), [&](int batch) {
+            transformInstanceVertices(mesh, instanceViews.data(), (size_t)batch * projectBatch,
+                                      std::min(totalVertices, (size_t)(batch + 1) * projectBatch));
+        });
+        
+        int triangleCount = (int)mesh.getTriangleCount();
+        assembleBatches((int)instanceViews.size() * triangleCount, [&](int begin, int end, PrimitiveStats& stats, auto& emit) {
+            for (int i = begin; i < end; ++i) {
+                int instance = i / triangleCount;
+                assembleIndexed(mesh, i - instance * triangleCount, postTransform.data() + instance * vertexCount,
+                                instanceViews[instance].instance, stats, emit);
+            }
+        });
+    }
+    
+    // Bins projectedTriangles into each screen tile their bounding box
+    // touches, then rasterizes tiles in parallel. Each tile owns a disjoint
+    // slice of the frame buffer and keeps submission order within its bin, so
+    // no locking is needed and the output matches the single-threaded path.
+    void rasterizeTiles() {
+        int triangleCount = (int)projectedTriangles.size();
+        if (triangleCount == 0) return;
+        
+        // IDs continue from the triangles drawn earlier in the frame
+        uint32_t firstId = 0;
+        if (visibilityMode) {
+            firstId = (uint32_t)visibilityTriangles.size() + 1;
+            visibilityTriangles.insert(visibilityTriangles.end(), projectedTriangles.begin(), projectedTriangles.end());
+        }
+        
+        StageClock::time_point mark = startStage();
+        int tilesX = (frameBuffer.width + tileSize - 1) / tileSize;
+        int tilesY = (frameBuffer.height + tileSize - 1) / tileSize;
+        tileBins.resize(tilesX * tilesY);
+        for (auto& bin : tileBins) bin.clear();
+        
+        for (int i = 0; i < triangleCount; ++i) {
+            const ProjectedTriangle& pt = projectedTriangles[i];
+            for (int ty = pt.minY / tileSize; ty <= pt.maxY / tileSize; ++ty) {
+                for (int tx = pt.minX / tileSize; tx <= pt.maxX / tileSize; ++tx) {
+                    tileBins[ty * tilesX + tx].push_back((uint32_t)i);
+                }
+            }
+        }
+        chargeStage(stageTimings.binning, mark);
+        
+        workerPool->parallelFor(tilesX * tilesY, [&](int tile) {
+            const auto& bin = tileBins[tile];
+            if (bin.empty()) return;
+            
+            int tileMinX = (tile % tilesX) * tileSize;
+            int tileMinY = (tile / tilesX) * tileSize;
+            int tileMaxX = std::min(frameBuffer.width, tileMinX + tileSize) - 1;
+            int tileMaxY = std::min(frameBuffer.height, tileMinY + tileSize) - 1;
+            
+            for (uint32_t index : bin) {
+                rasterizeProjected(projectedTriangles[index], tileMinX, tileMinY, tileMaxX, tileMaxY, firstId ? firstId + index : 0);
+            }
+        });
+        chargeStage(stageTimings.raster, mark);
+    }
+    
+    template <typename MeshType>
+    bool isMeshVisible(const MeshType& mesh) {
+        if (frustum.intersects(mesh.getBoundingSphere()) && frustum.intersects(mesh.getBounds())) return true;
+        ++primitiveStats.culledMeshes;
+        return false;
+    }
+    
+    // True when a mesh's world-space bounding box lies entirely behind the
+    // hierarchical depth buffer. Boxes that reach the near plane are never
+    // rejected, since their screen footprint is unbounded.
+    bool isBoxOccluded(const BoundingBox& box) {
+        if (!occlusionCulling) return false;
+        
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearestZ = FLT_MAX;
+        for (int corner = 0; corner < 8; ++corner) {
+            vector3 p((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z);
+            vector3 cameraSpace = camera.worldToCameraSpace(p);
+            if (cameraSpace.z < camera.nearZ) return false;
+            
+            vector3 screen = cameraToScreen(cameraSpace);
+            minX = std::min(minX, screen.x);
+            maxX = std::max(maxX, screen.x);
+            minY = std::min(minY, screen.y);
+            maxY = std::max(maxY, screen.y);
+            nearestZ = std::min(nearestZ, cameraSpace.z);
+        }
+        
+        if (maxX < 0 || maxY < 0 || minX > frameBuffer.width || minY > frameBuffer.height) return false;
+        int blockMinX = (int)std::floor(std::max(minX, 0.0f)) / RS_BLOCK_SIZE;
+        int blockMinY = (int)std::floor(std::max(minY, 0.0f)) / RS_BLOCK_SIZE;
+        int blockMaxX = (int)std::ceil(std::min(maxX, (float)(frameBuffer.width - 1))) / RS_BLOCK_SIZE;
+        int blockMaxY = (int)std::ceil(std::min(maxY, (float)(frameBuffer.height - 1))) / RS_BLOCK_SIZE;
+        
+        float occlusionZ = nearestZ * hiZTolerance;
+        for (int by = blockMinY; by <= blockMaxY; ++by) {
+            for (int bx = blockMinX; bx <= blockMaxX; ++bx) {
+                if (occlusionZ < frameBuffer.getHiZ(bx, by)) return false;
+            }
+        }
+        ++primitiveStats.occludedMeshes;
+        return true;
+    }
+    
+    template <typename Emit>
+    void assembleMesh(const Mesh& mesh, PrimitiveStats& stats, Emit&& emit) {
+        for (const auto& tri : mesh.triangles) assembleTriangle(tri, mesh.texture, stats, emit);
+    }
+    
+    // Transforms each unique vertex once into the post-transform cache, then
+    // assembles the triangles that reference it
+    template <typename Emit>
+    void assembleMesh(const IndexedMesh& mesh, PrimitiveStats& stats, Emit&& emit) {
+        assembleMesh(mesh.getView(), stats, emit);
+    }
+    
+    template <typename Emit>
+    void assembleMesh(const IndexedMeshView& mesh, PrimitiveStats& stats, Emit&& emit) {
+        postTransform.resize(mesh.getVertexCount());
+        transformVertices(mesh, 0, mesh.getVertexCount());
+        
+        size_t triangleCount = mesh.getTriangleCount();
+        for (size_t i = 0; i < triangleCount; ++i) assembleIndexed(mesh, i, postTransform.data(), nullptr, stats, emit);
+    }
+    
+    template <typename Emit>
+    void assembleInstance(const Mesh& mesh, const InstanceView& view, PrimitiveStats& stats, Emit&& emit) {
+        for (const auto& tri : mesh.triangles) assembleTriangle(tri, mesh.texture, view, stats, emit);
+    }
+    
+    template <typename Emit>
+    void assembleInstance(const IndexedMeshView& mesh, const InstanceView& view, PrimitiveStats& stats, Emit&& emit) {
+        postTransform.resize(mesh.getVertexCount());
+        transformInstanceVertices(mesh, &view, 0, mesh.getVertexCount());
+        
+        size_t triangleCount = mesh.getTriangleCount();
+        for (size_t i = 0; i < triangleCount; ++i) assembleIndexed(mesh, i, postTransform.data(), view.instance, stats, emit);
+    }
+    
+    // Common entry point of every mesh draw: rejects meshes whose bounds are
+    // outside the view frustum or hidden behind what is already drawn, then
+    // renders the rest in the given order. Tiled mode tests occlusion against
+    // earlier draws and occluders only, since it rasterizes after assembly.
+    template <typename MeshType, typename MeshAt>
+    void drawMeshes(size_t meshCount, MeshAt meshAt) {
+        updateViewConstants();
+        StageClock::time_point mark = startStage();
+        
+        if (!tiledMode) {
+            for (size_t i = 0; i < meshCount; ++i) {
+                const MeshType& mesh = meshAt(i);
+                bool visible = isMeshVisible(mesh) && !isBoxOccluded(mesh.getBounds());
+                chargeStage(stageTimings.cull, mark);
+                if (!visible) continue;
+                assembleMesh(mesh, primitiveStats, [&](const ProjectedTriangle& pt) { rasterizeFullScreen(pt); });
+                chargeStage(stageTimings.raster, mark);
+            }
+            return;
+        }
+        
+        std::vector<const MeshType*> visibleMeshes;
+        visibleMeshes.reserve(meshCount);
+        for (size_t i = 0; i < meshCount; ++i) {
+            const MeshType& mesh = meshAt(i);
+            if (isMeshVisible(mesh) && !isBoxOccluded(mesh.getBounds())) visibleMeshes.push_back(&mesh);
+        }
+        chargeStage(stageTimings.cull, mark);
+        projectTiled(visibleMeshes.data(), visibleMeshes.size());
+        chargeStage(stageTimings.assembly, mark);
+        rasterizeTiles();
+    }
+    
+    // Culls one instance by its transformed bounds; a visible instance gets
+    // its model-view transform, composed once for all of its vertices
+    bool prepareInstance(const BoundingBox& meshBounds, const Instance& instance, InstanceView& view) {
+        BoundingBox box = instance.transform.transformBox(meshBounds);
+        if (!frustum.intersects(box)) {
+            ++primitiveStats.culledMeshes;
+            return false;
+        }
+        if (isBoxOccluded(box)) return false;
+        
+        view.modelView = viewTransform * instance.transform;
+        view.instance = &instance;
+        return true;
+    }
+    
+    // Instanced counterpart of drawMeshes: the mesh is shared and only the
+    // per-instance transform and tint change between copies
+    template <typename MeshType>
+    void drawInstances(const MeshType& mesh, const std::vector<Instance>& instances) {
+        updateViewConstants();
+        const BoundingBox& bounds = mesh.getBounds();
+        InstanceView view;
+        StageClock::time_point mark = startStage();
+        
+        if (!tiledMode) {
+            for (const auto& instance : instances) {
+                bool visible = prepareInstance(bounds, instance, view);
+                chargeStage(stageTimings.cull, mark);
+                if (!visible) continue;
+                assembleInstance(mesh, view, primitiveStats, [&](const ProjectedTriangle& pt) { rasterizeFullScreen(pt); });
+                chargeStage(stageTimings.raster, mark);
+            }
+            return;
+        }
+        
+        instanceViews.clear();
+        for (const auto& instance : instances) {
+            if (prepareInstance(bounds, instance, view)) instanceViews.push_back(view);
+        }
+        chargeStage(stageTimings.cull, mark);
+        projectInstancesTiled(mesh);
+        chargeStage(stageTimings.assembly, mark);
+        rasterizeTiles();
+    }
+    
+    // Lowers the hierarchical depth bound of every block the triangle fully
+    // covers to the triangle's farthest depth, leaving the frame buffer as is
+    void rasterizeOccluder(const ProjectedTriangle& pt) {
+        RasterSetup rs;
+        if (!setupRaster(pt, 0, 0, frameBuffer.width - 1, frameBuffer.height - 1, rs)) return;
+        
+        float farthestZ = std::max(rs.z0, std::max(rs.z1, rs.z2)) / hiZTolerance;
+        for (int by = rs.minY & ~(RS_BLOCK_SIZE - 1); by <= rs.maxY; by += RS_BLOCK_SIZE) {
+            for (int bx = rs.minX & ~(RS_BLOCK_SIZE - 1); bx <= rs.maxX; bx += RS_BLOCK_SIZE) {
+                if (classifyBlock(rs, bx, by) != 0) continue;
+                float& bound = frameBuffer.hiZ[(by / RS_BLOCK_SIZE) * frameBuffer.blocksX + bx / RS_BLOCK_SIZE];
+                bound = std::min(bound, farthestZ);
+            }
+        }
+    }
+    
+    template <typename MeshType>
+    void drawOccluders(const std::vector<MeshType>& occluders) {
+        if (!occlusionCulling) return;
+        
+        updateViewConstants();
+        PrimitiveStats occluderStats;
+        for (const auto& mesh : occluders) {
+            if (!frustum.intersects(mesh.getBounds())) continue;
+            assembleMesh(mesh, occluderStats, [&](const ProjectedTriangle& pt) { rasterizeOccluder(pt); });
+        }
+    }
+    
+    template <typename MeshType>
+    void drawHierarchy(const std::vector<MeshType>& meshes, const SceneBVH& bvh) {
+        StageClock::time_point mark = startStage();
+        bvh.cull(Frustum(camera), visibleItems);
+        primitiveStats.culledMeshes += meshes.size() - visibleItems.size();
+        chargeStage(stageTimings.cull, mark);
+        drawMeshes<MeshType>(visibleItems.size(), [&](size_t i) -> const MeshType& { return meshes[visibleItems[i]]; });
+    }
+    
+    void rasterizeFullScreen(const ProjectedTriangle& pt) {
+        uint32_t visibilityId = 0;
+        if (visibilityMode) {
+            visibilityTriangles.push_back(pt);
+            visibilityId = (uint32_t)visibilityTriangles.size();
+        }
+        rasterizeProjected(pt, 0, 0, frameBuffer.width - 1, frameBuffer.height - 1, visibilityId);
+    }
+
+#if RS_SIMD_WIDTH > 1
+    // Shades the chunks of a block's pixel row whose IDs all name the same
+    // triangle (or none) with the forward kernels' chunk shading and clears
+    // their IDs, leaving mixed chunks to the per-pixel path. Returns true
+    // when the whole row was resolved.
+    bool resolveRowChunks(uint32_t* ids, uint32_t* colors, int64_t blockX, int64_t fixedY) {
+        const int chunkWidth = RS_SIMD_WIDTH;
+        bool resolved = true;
+        for (int cx = 0; cx < RS_BLOCK_SIZE; cx += chunkWidth) {
+            uint32_t id = 0;
+            for (int lane = 0; lane < chunkWidth && !id; ++lane) id = ids[cx + lane];
+            if (!id) continue;
+            bool uniform = true;
+            for (int lane = 0; lane < chunkWidth; ++lane) uniform = uniform && (ids[cx + lane] == id || !ids[cx + lane]);
+            if (!uniform) {
+                resolved = false;
+                continue;
+            }
+            
+            const RasterSetup& rs = visibilitySetups[id - 1];
+            float rowE0 = (float)rs.edges[0].at(blockX, fixedY);
+            float rowE1 = (float)rs.edges[1].at(blockX, fixedY);
+            float rowE2 = (float)rs.edges[2].at(blockX, fixedY);
+#if RS_SIMD_WIDTH == 8
+            __m256 planeSteps[chunkPlaneCount];
+            setupChunkSteps(rs, _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f), planeSteps);
+            __m256i chunkIds = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + cx));
+            __m256i laneMask = _mm256_xor_si256(_mm256_cmpeq_epi32(chunkIds, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+            __m256 inverseDepth = _mm256_add_ps(_mm256_set1_ps(rs.inverseDepth.rowValue(rowE0, rowE1, rowE2)), planeSteps[0]);
+            __m256 z = _mm256_div_ps(_mm256_set1_ps(1.0f), inverseDepth);
+            __m256i packed = shadeChunk(rs, planeSteps, rowE0, rowE1, rowE2, z, _mm256_movemask_ps(_mm256_castsi256_ps(laneMask)));
+            _mm256_maskstore_epi32(reinterpret_cast<int*>(colors + cx), laneMask, packed);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(ids + cx), _mm256_setzero_si256());
+#else
+            __m128 planeSteps[chunkPlaneCount];
+            __m128 laneOffsets = _mm_add_ps(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_set1_ps((float)cx));
+            setupChunkSteps(rs, laneOffsets, planeSteps);
+            __m128i chunkIds = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + cx));
+            __m128i keep = _mm_cmpeq_epi32(chunkIds, _mm_setzero_si128());
+            __m128 inverseDepth = _mm_add_ps(_mm_set1_ps(rs.inverseDepth.rowValue(rowE0, rowE1, rowE2)), planeSteps[0]);
+            __m128 z = _mm_div_ps(_mm_set1_ps(1.0f), inverseDepth);
+            __m128i packed = shadeChunk(rs, planeSteps, rowE0, rowE1, rowE2, z);
+            __m128i* target = reinterpret_cast<__m128i*>(colors + cx);
+            __m128i old = _mm_loadu_si128(target);
+            _mm_storeu_si128(target, _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, packed)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(ids + cx), _mm_setzero_si128());
+#endif
+        }
+        return resolved;
+    }
+#endif
+    
+    // Shades the visibility buffer pixels of one row of blocks and clears
+    // their IDs. Each pixel is shaded from its triangle's setup exactly as the
+    // forward kernels would have shaded it.
+    void resolveVisibilityBlockRow(int blockY) {
+        uint32_t* visibilityBuffer = frameBuffer.visibilityBuffer.data();
+        uint32_t* colorBuffer = reinterpret_cast<uint32_t*>(frameBuffer.colorBuffer.data());
+        PixelShader shader(colorBuffer);
+        const int64_t half = 1 << (RS_SUBPIXEL_BITS - 1);
+        int by = blockY * RS_BLOCK_SIZE, endY = std::min(by + RS_BLOCK_SIZE, frameBuffer.height);
+        
+        for (int bx = 0; bx < frameBuffer.width; bx += RS_BLOCK_SIZE) {
+            // IDs in a block whose clear is pending belong to an earlier frame
+            if (frameBuffer.isClearPending(bx, by)) continue;
+            int endX = std::min(bx + RS_BLOCK_SIZE, frameBuffer.width);
+            int64_t blockX = ((int64_t)bx << RS_SUBPIXEL_BITS) + half;
+            
+            for (int y = by; y < endY; ++y) {
+                int64_t fixedY = ((int64_t)y << RS_SUBPIXEL_BITS) + half;
+                int rowIndex = frameBuffer.pixelIndex(bx, y) - bx;
+#if RS_SIMD_WIDTH > 1
+                bool fullRow = frameBuffer.isTiled() || endX == bx + RS_BLOCK_SIZE;
+                if (simdEnabled && fullRow &&
+                    resolveRowChunks(visibilityBuffer + rowIndex + bx, colorBuffer + rowIndex + bx, blockX, fixedY)) continue;
+#endif
+                uint32_t rowId = 0;
+                RowPlanes row = {};
+                for (int x = bx; x < endX; ++x) {
+                    int index = rowIndex + x;
+                    uint32_t id = visibilityBuffer[index];
+                    if (!id) continue;
+                    visibilityBuffer[index] = 0;
+                    
+                    const RasterSetup& rs = visibilitySetups[id - 1];
+                    if (id != rowId) {
+                        evaluateRow(rs, blockX, fixedY, row);
+                        rowId = id;
+                    }
+                    float dx = (float)(x - bx);
+                    float z = 1.0f / (row.inverseDepth + dx * rs.inverseDepth.stepX);
+                    shader.shade(rs, row, dx, z, index);
+                }
+            }
+        }
+        shader.flush();
+    }
+
+public:
+    RenderSystem(FrameBuffer& fb, Camera& cam) : frameBuffer(fb), camera(cam) {}
+    
+    // Enables tile-binned multithreaded rendering for renderMesh/renderScene.
+    // workerCount == 0 uses every hardware thread.
+    void setTiledMode(bool enabled, int tiles = 64, unsigned workerCount = 0) {
+        tiledMode = enabled;
+        // Tiles must start on coverage block boundaries to match the untiled output
+        tileSize = std::max(RS_BLOCK_SIZE, (tiles + RS_BLOCK_SIZE - 1) & ~(RS_BLOCK_SIZE - 1));
+        if (!enabled) {
+            workerPool.reset();
+            return;
+        }
+        
+        if (!workerPool || (workerCount > 0 && workerPool->getThreadCount() != workerCount)) {
+            workerPool.reset(new WorkerPool(workerCount > 0 ? (int)workerCount - 1 : -1));
+        }
+    }
+    
+    bool isTiledMode() const { return tiledMode; }
+    
+    // Selects the vectorized rasterizer kernel when the build has one (RS_SIMD_WIDTH > 1).
+    // Disabling it forces the scalar reference loop.
+    void setSimdEnabled(bool enabled) { simdEnabled = enabled; }
+    
+    bool isSimdEnabled() const { return simdEnabled && RS_SIMD_WIDTH > 1; }
+    
+    // Culling mode of the primitive assembly stage; front faces are the ones
+    // that are counter-clockwise on screen
+    void setCullMode(CullMode mode) { cullMode = mode; }
+    
+    CullMode getCullMode() const { return cullMode; }
+    
+    // Assembly counters accumulate across draws until reset, typically once per frame
+    const PrimitiveStats& getPrimitiveStats() const { return primitiveStats; }
+    
+    void resetPrimitiveStats() { primitiveStats = PrimitiveStats(); }
+    
+    // Per-stage wall-clock timing for profiling; off by default, since
+    // untiled draws read the clock twice per mesh
+    void setStageTimingEnabled(bool enabled) { stageTiming = enabled; }
+    
+    bool isStageTimingEnabled() const { return stageTiming; }
+    
+    const StageTimings& getStageTimings() const { return stageTimings; }
+    
+    void resetStageTimings() { stageTimings = StageTimings(); }
+    
+    // Hierarchical depth culling skips blocks, triangles and whole meshes
+    // hidden behind what is already drawn; the output is unchanged
+    void setOcclusionCullingEnabled(bool enabled) { occlusionCulling = enabled; }
+    
+    bool isOcclusionCullingEnabled() const { return occlusionCulling; }
+    
+    // Two-pass visibility-buffer rendering. While enabled, draws only depth
+    // test their triangles and store the ID of the nearest one per pixel;
+    // resolveVisibility then shades every covered pixel exactly once, so the
+    // shading cost follows the screen size instead of the depth complexity.
+    // Resolve once per frame after the draws, before reading colors.
+    // Disabling the mode resolves any pending draws.
+    void setVisibilityBufferEnabled(bool enabled) {
+        if (!enabled) resolveVisibility();
+        visibilityMode = enabled;
+        if (enabled) frameBuffer.enableVisibilityBuffer();
+    }
+    
+    bool isVisibilityBufferEnabled() const { return visibilityMode; }
+    
+    // Second pass: shades the pixels the visibility buffer holds IDs for and
+    // clears the buffer for the next frame. Tiled mode shades in parallel.
+    void resolveVisibility() {
+        if (visibilityTriangles.empty()) return;
+        StageClock::time_point mark = startStage();
+        
+        size_t triangleCount = visibilityTriangles.size();
+        visibilitySetups.resize(triangleCount);
+        auto setupRange = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                setupRaster(visibilityTriangles[i], 0, 0, frameBuffer.width - 1, frameBuffer.height - 1, visibilitySetups[i]);
+            }
+        };
+        if (tiledMode) {
+            workerPool->parallelFor((int)((triangleCount + projectBatch - 1) / projectBatch), [&](int batch) {
+                setupRange((size_t)batch * projectBatch, std::min(triangleCount, (size_t)(batch + 1) * projectBatch));
+            });
+            workerPool->parallelFor(frameBuffer.blocksY, [&](int blockY) { resolveVisibilityBlockRow(blockY); });
+        }
+        else {
+            setupRange(0, triangleCount);
+            for (int blockY = 0; blockY < frameBuffer.blocksY; ++blockY) resolveVisibilityBlockRow(blockY);
+        }
+        
+        visibilityTriangles.clear();
+        chargeStage(stageTimings.resolve, mark);
+    }
+    
+    void rasterizeTriangle(const Triangle& tri, const Texture* texture = nullptr) {
+        updateViewConstants();
+        assembleTriangle(tri, texture, primitiveStats, [&](const ProjectedTriangle& pt) { rasterizeFullScreen(pt); });
+    }
+    
+    void renderMesh(const Mesh& mesh) {
+        drawMeshes<Mesh>(1, [&](size_t) -> const Mesh& { return mesh; });
+    }
+    
+    void renderMesh(const IndexedMesh& mesh) {
+        drawMeshes<IndexedMesh>(1, [&](size_t) -> const IndexedMesh& { return mesh; });
+    }
+    
+    // Draws geometry that lives outside an IndexedMesh, such as a MappedMesh,
+    // without copying it
+    void renderMesh(const IndexedMeshView& mesh) {
+        drawMeshes<IndexedMeshView>(1, [&](size_t) -> const IndexedMeshView& { return mesh; });
+    }
+    
+    void renderScene(const std::vector<Mesh>& meshes) {
+        drawMeshes<Mesh>(meshes.size(), [&](size_t i) -> const Mesh& { return meshes[i]; });
+    }
+    
+    void renderScene(const std::vector<IndexedMesh>& meshes) {
+        drawMeshes<IndexedMesh>(meshes.size(), [&](size_t i) -> const IndexedMesh& { return meshes[i]; });
+    }
+    
+    // Renders the meshes the hierarchy finds inside the view frustum, in
+    // scene order. The hierarchy must have been built from these meshes and
+    // kept up to date as they move.
+    void renderScene(const std::vector<Mesh>& meshes, const SceneBVH& bvh) {
+        drawHierarchy(meshes, bvh);
+    }
+    
+    void renderScene(const std::vector<IndexedMesh>& meshes, const SceneBVH& bvh) {
+        drawHierarchy(meshes, bvh);
+    }
+    
+    // Renders each chain at the level of detail its distance calls for; the
+    // chains remember their level between frames for hysteresis
+    void renderScene(std::vector<MeshLOD>& lods) {
+        selectedLevels.clear();
+        for (auto& lod : lods) {
+            if (lod.getLevelCount() > 0) selectedLevels.push_back(&lod.select(camera, frameBuffer.width));
+        }
+        drawMeshes<Mesh>(selectedLevels.size(), [&](size_t i) -> const Mesh& { return *selectedLevels[i]; });
+    }
+    
+    // Sorts the queue for the current camera and renders it in that order.
+    // Consecutive draws of the same mesh type are batched, which keeps tiled
+    // mode parallel across them.
+    void renderScene(RenderQueue& queue) {
+        queue.sort(camera);
+        
+        size_t count = queue.size();
+        for (size_t begin = 0; begin < count;) {
+            bool indexed = queue.getItem(begin).indexedMesh != nullptr;
+            size_t end = begin + 1;
+            while (end < count && (queue.getItem(end).indexedMesh != nullptr) == indexed) ++end;
+            
+            if (indexed) drawMeshes<IndexedMesh>(end - begin, [&](size_t i) -> const IndexedMesh& { return *queue.getItem(begin + i).indexedMesh; });
+            else drawMeshes<Mesh>(end - begin, [&](size_t i) -> const Mesh& { return *queue.getItem(begin + i).mesh; });
+            begin = end;
+        }
+    }
+    
+    // Draws one copy of the mesh per instance, each placed by its transform
+    // and tinted by its color. Instances are culled individually and drawn
+    // in array order.
+    void renderInstanced(const Mesh& mesh, const std::vector<Instance>& instances) {
+        drawInstances(mesh, instances);
+    }
+    
+    void renderInstanced(const IndexedMesh& mesh, const std::vector<Instance>& instances) {
+        drawInstances(mesh.getView(), instances);
+    }
+    
+    void renderInstanced(const IndexedMeshView& mesh, const std::vector<Instance>& instances) {
+        drawInstances(mesh, instances);
+    }
+    
+    // Optional pre-pass over a few large occluders, such as walls, after the
+    // frame buffer is cleared. Only the hierarchical depth buffer is updated,
+    // so later draws can skip what the occluders hide. Occluders must also be
+    // drawn as part of the scene, or the surfaces behind them go missing.
+    void renderOccluders(const std::vector<Mesh>& occluders) {
+        drawOccluders(occluders);
+    }
+    
+    void renderOccluders(const std::vector<IndexedMesh>& occluders) {
+        drawOccluders(occluders);
+    }
+};
+
+// Mesh generators for common shapes
+namespace MeshGenerators {
+    inline Mesh createCube(float size = 1.0f, const Color& color = Color(255, 0, 0)) {
+        Mesh cube(color);
+        float halfSize = size * 0.5f;
+        
+        std::vector<Vertex> vertices = {
+            Vertex(vector3(-halfSize, -halfSize, halfSize), color),
+            Vertex(vector3(halfSize, -halfSize, halfSize), color),
+            Vertex(vector3(halfSize, halfSize, halfSize), color),
+            Vertex(vector3(-halfSize, halfSize, halfSize), color),
+            Vertex(vector3(-halfSize, -halfSize, -halfSize), color),
+            Vertex(vector3(-halfSize, halfSize, -halfSize), color),
+            Vertex(vector3(halfSize, halfSize, -halfSize), color),
+            Vertex(vector3(halfSize, -halfSize, -halfSize), color),
+            Vertex(vector3(-halfSize, halfSize, -halfSize), color),
+            Vertex(vector3(-halfSize, halfSize, halfSize), color),
+            Vertex(vector3(halfSize, halfSize, halfSize), color),
+            Vertex(vector3(halfSize, halfSize, -halfSize), color),
+            Vertex(vector3(-halfSize, -halfSize, -halfSize), color),
+            Vertex(vector3(halfSize, -halfSize, -halfSize), color),
+            Vertex(vector3(halfSize, -halfSize, halfSize), color),
+            Vertex(vector3(-halfSize, -halfSize, halfSize), color),
+            Vertex(vector3(halfSize, -halfSize, -halfSize), color),
             Vertex(vector3(halfSize, halfSize, -halfSize), color),
             Vertex(vector3(halfSize, halfSize, halfSize), color),
             Vertex(vector3(halfSize, -halfSize, halfSize), color),
@@ -264,7 +3444,7 @@ namespace MeshGenerators {
         return cube;
     }
     
-    Mesh createPyramid(float baseSize = 1.0f, float height = 1.0f, const Color& color = Color(0, 255, 0)) {
+    inline Mesh createPyramid(float baseSize = 1.0f, float height = 1.0f, const Color& color = Color(0, 255, 0)) {
         Mesh pyramid(color);
         float halfBase = baseSize * 0.5f;
         
@@ -283,6 +3463,16 @@ namespace MeshGenerators {
         
         return pyramid;
     }
+    
+    // Indexed variants weld the shared corners, so a flat-colored cube
+    // transforms 8 vertices per frame instead of 36
+    inline IndexedMesh createIndexedCube(float size = 1.0f, const Color& color = Color(255, 0, 0)) {
+        return IndexedMesh::fromMesh(createCube(size, color));
+    }
+    
+    inline IndexedMesh createIndexedPyramid(float baseSize = 1.0f, float height = 1.0f, const Color& color = Color(0, 255, 0)) {
+        return IndexedMesh::fromMesh(createPyramid(baseSize, height, color));
+    }
 }
 
 #endif
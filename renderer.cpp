@@ -1,14 +1,243 @@
 #include "renderer.h"
+#include "text.h"
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+
+// widest row kernels the compiler targets
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FRAME_BLIT_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAME_BLIT_SSE2
+#endif
 
 namespace frame{
+	// row kernels of the blits; dst and src hold count pixels
+
+	static void copyRow(uint32_t* dst, const uint32_t* src, int count) {
+		memcpy(dst, src, count * sizeof(uint32_t));
+	}
+
+	static void fillRow(uint32_t* dst, int count, uint32_t color) {
+		int x = 0;
+#if defined(FRAME_BLIT_AVX2)
+		const __m256i color8 = _mm256_set1_epi32((int)color);
+		for (; x + 8 <= count; x += 8)
+			_mm256_storeu_si256((__m256i*)(dst + x), color8);
+#endif
+#if defined(FRAME_BLIT_SSE2)
+		const __m128i color4 = _mm_set1_epi32((int)color);
+		for (; x + 4 <= count; x += 4)
+			_mm_storeu_si128((__m128i*)(dst + x), color4);
+#endif
+		for (; x < count; x++)
+			dst[x] = color;
+	}
+
+	// swaps red and blue, converting between BGRX and RGBA; dst may be src
+	static void swizzleRow(uint32_t* dst, const uint32_t* src, int count) {
+		int x = 0;
+#if defined(FRAME_BLIT_AVX2)
+		const __m256i greenAlpha8 = _mm256_set1_epi32((int)0xFF00FF00);
+		for (; x + 8 <= count; x += 8) {
+			__m256i source = _mm256_loadu_si256((const __m256i*)(src + x));
+			__m256i redBlue = _mm256_andnot_si256(greenAlpha8, source);
+			redBlue = _mm256_or_si256(_mm256_slli_epi32(redBlue, 16), _mm256_srli_epi32(redBlue, 16));
+			_mm256_storeu_si256((__m256i*)(dst + x), _mm256_or_si256(_mm256_and_si256(source, greenAlpha8), redBlue));
+		}
+#endif
+#if defined(FRAME_BLIT_SSE2)
+		const __m128i greenAlpha = _mm_set1_epi32((int)0xFF00FF00);
+		for (; x + 4 <= count; x += 4) {
+			__m128i source = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i redBlue = _mm_andnot_si128(greenAlpha, source);
+			redBlue = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_and_si128(source, greenAlpha), redBlue));
+		}
+#endif
+		for (; x < count; x++) {
+			uint32_t pixel = src[x];
+			dst[x] = (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) | ((pixel & 0xFF) << 16);
+		}
+	}
+
+	static void colorKeyRow(uint32_t* dst, const uint32_t* src, int count, uint32_t key) {
+		key &= 0xFFFFFF;
+		int x = 0;
+#if defined(FRAME_BLIT_AVX2)
+		const __m256i rgbMask8 = _mm256_set1_epi32(0xFFFFFF);
+		const __m256i key8 = _mm256_set1_epi32((int)key);
+		for (; x + 8 <= count; x += 8) {
+			__m256i source = _mm256_loadu_si256((const __m256i*)(src + x));
+			__m256i keyed = _mm256_cmpeq_epi32(_mm256_and_si256(source, rgbMask8), key8);
+			__m256i target = _mm256_loadu_si256((const __m256i*)(dst + x));
+			_mm256_storeu_si256((__m256i*)(dst + x), _mm256_blendv_epi8(source, target, keyed));
+		}
+#endif
+#if defined(FRAME_BLIT_SSE2)
+		const __m128i rgbMask = _mm_set1_epi32(0xFFFFFF);
+		const __m128i key4 = _mm_set1_epi32((int)key);
+		for (; x + 4 <= count; x += 4) {
+			__m128i source = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i keyed = _mm_cmpeq_epi32(_mm_and_si128(source, rgbMask), key4);
+			__m128i target = _mm_loadu_si128((const __m128i*)(dst + x));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_and_si128(keyed, target), _mm_andnot_si128(keyed, source)));
+		}
+#endif
+		for (; x < count; x++) {
+			if ((src[x] & 0xFFFFFF) != key)
+				dst[x] = src[x];
+		}
+	}
+
+	// (s * a + d * (255 - a)) / 255 per channel, rounded; the vector kernels
+	// compute the same formula on 16-bit lanes
+	static inline uint32_t blendPixel(uint32_t s, uint32_t d) {
+		uint32_t a = s >> 24;
+		uint32_t result = 0;
+		for (int shift = 0; shift < 32; shift += 8) {
+			uint32_t t = ((s >> shift) & 0xFF) * a + ((d >> shift) & 0xFF) * (255 - a) + 128;
+			result |= ((t + (t >> 8)) >> 8) << shift;
+		}
+		return result;
+	}
+
+#if defined(FRAME_BLIT_SSE2)
+	// blends the two pixels unpacked in s over the two in d
+	static inline __m128i blendPixels2(__m128i s, __m128i d) {
+		__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+		__m128i t = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a)));
+		t = _mm_add_epi16(t, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	}
+#endif
+
+#if defined(FRAME_BLIT_AVX2)
+	static inline __m256i blendPixels4(__m256i s, __m256i d) {
+		__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+		__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a)));
+		t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+	}
+#endif
+
+	static void alphaRow(uint32_t* dst, const uint32_t* src, int count) {
+		int x = 0;
+#if defined(FRAME_BLIT_AVX2)
+		const __m256i alphaMask8 = _mm256_set1_epi32((int)0xFF000000);
+		for (; x + 8 <= count; x += 8) {
+			__m256i source = _mm256_loadu_si256((const __m256i*)(src + x));
+			__m256i alpha = _mm256_and_si256(source, alphaMask8);
+			// whole runs of opaque or transparent pixels skip the arithmetic
+			if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alphaMask8)) == -1) {
+				_mm256_storeu_si256((__m256i*)(dst + x), source);
+				continue;
+			}
+			if (_mm256_testz_si256(alpha, alpha))
+				continue;
+
+			__m256i target = _mm256_loadu_si256((const __m256i*)(dst + x));
+			__m256i zero = _mm256_setzero_si256();
+			__m256i low = blendPixels4(_mm256_unpacklo_epi8(source, zero), _mm256_unpacklo_epi8(target, zero));
+			__m256i high = blendPixels4(_mm256_unpackhi_epi8(source, zero), _mm256_unpackhi_epi8(target, zero));
+			_mm256_storeu_si256((__m256i*)(dst + x), _mm256_packus_epi16(low, high));
+		}
+#endif
+#if defined(FRAME_BLIT_SSE2)
+		const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+		for (; x + 4 <= count; x += 4) {
+			__m128i source = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i alpha = _mm_and_si128(source, alphaMask);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+				_mm_storeu_si128((__m128i*)(dst + x), source);
+				continue;
+			}
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) == 0xFFFF)
+				continue;
+
+			__m128i target = _mm_loadu_si128((const __m128i*)(dst + x));
+			__m128i zero = _mm_setzero_si128();
+			__m128i low = blendPixels2(_mm_unpacklo_epi8(source, zero), _mm_unpacklo_epi8(target, zero));
+			__m128i high = blendPixels2(_mm_unpackhi_epi8(source, zero), _mm_unpackhi_epi8(target, zero));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(low, high));
+		}
+#endif
+		for (; x < count; x++)
+			dst[x] = blendPixel(src[x], dst[x]);
+	}
+
+	// blends color over dst by coverage (0 .. 255 per pixel), through the alpha kernel
+	static void coverageRow(uint32_t* dst, const int32_t* coverage, int count, uint32_t color) {
+		const int chunkSize = 256;
+		uint32_t span[chunkSize];
+
+		color &= 0xFFFFFF;
+		for (int x = 0; x < count; x += chunkSize) {
+			int chunk = std::min(chunkSize, count - x);
+			for (int i = 0; i < chunk; i++)
+				span[i] = color | ((uint32_t)std::min(coverage[x + i], 255) << 24);
+			alphaRow(dst + x, span, chunk);
+		}
+	}
+
+	// blends color over dst by 8-bit coverage, through the alpha kernel
+	static void tintRow(uint32_t* dst, const uint8_t* coverage, int count, uint32_t color) {
+		const int chunkSize = 256;
+		uint32_t span[chunkSize];
+
+		color &= 0xFFFFFF;
+		for (int x = 0; x < count; x += chunkSize) {
+			int chunk = std::min(chunkSize, count - x);
+			int i = 0;
+#if defined(FRAME_BLIT_SSE2)
+			// widen 16 coverage bytes at a time into the alpha byte of 16 pixels
+			const __m128i color4 = _mm_set1_epi32((int)color);
+			const __m128i zero = _mm_setzero_si128();
+			for (; i + 16 <= chunk; i += 16) {
+				__m128i bytes = _mm_loadu_si128((const __m128i*)(coverage + x + i));
+				__m128i low = _mm_unpacklo_epi8(zero, bytes);
+				__m128i high = _mm_unpackhi_epi8(zero, bytes);
+				_mm_storeu_si128((__m128i*)(span + i), _mm_or_si128(_mm_unpacklo_epi16(zero, low), color4));
+				_mm_storeu_si128((__m128i*)(span + i + 4), _mm_or_si128(_mm_unpackhi_epi16(zero, low), color4));
+				_mm_storeu_si128((__m128i*)(span + i + 8), _mm_or_si128(_mm_unpacklo_epi16(zero, high), color4));
+				_mm_storeu_si128((__m128i*)(span + i + 12), _mm_or_si128(_mm_unpackhi_epi16(zero, high), color4));
+			}
+#endif
+			for (; i < chunk; i++)
+				span[i] = color | ((uint32_t)coverage[x + i] << 24);
+			alphaRow(dst + x, span, chunk);
+		}
+	}
+
+	static void blitRow(uint32_t* dst, const uint32_t* src, int count, BlendMode mode, uint32_t colorKey) {
+		switch (mode) {
+			case BlendMode::Opaque: copyRow(dst, src, count); break;
+			case BlendMode::ColorKey: colorKeyRow(dst, src, count, colorKey); break;
+			case BlendMode::Alpha: alphaRow(dst, src, count); break;
+		}
+	}
+
+	Image::Image(int width, int height, const uint32_t* argb) : width(width), height(height) {
+		pixels.resize((size_t)width * height);
+		if (argb)
+			memcpy(pixels.data(), argb, pixels.size() * sizeof(uint32_t));
+	}
+
 	void Renderer::SetPixel(int x, int y, const RGBColor& color) {
 		BitmapBuffer& buffer = getInstance().buffer;
 
-		if (x < 0 || x > buffer.width || y < 0 || y > buffer.height)
+		if (x < 0 || x >= buffer.width || y < 0 || y >= buffer.height)
 			return;
 
+		markDirty({ x, y, 1, 1 });
+
 		// convert (u8, u8, u8) to u32 for raw color
-		uint32_t raw_color = (color.red << 16) | (color.green << 8) | (color.blue << 0);
+		uint32_t raw_color = pack(color);
 
 		uint8_t* row = (uint8_t*)buffer.memory + x * bytes_per_pixel + y * buffer.pitch;
 		uint32_t* pixel = (uint32_t*)row;
@@ -16,6 +245,11 @@ namespace frame{
 	}
 
 	void Renderer::FillRectangle(const Rect& rect, const RGBColor& color){
+		markDirty(rect);
+		fill(rect, color);
+	}
+
+	void Renderer::fill(const Rect& rect, const RGBColor& color){
 		
 		BitmapBuffer& buffer = getInstance().buffer;
 
@@ -28,57 +262,711 @@ namespace frame{
 		if (minX < 0) minX = 0;
 		if (minY < 0) minY = 0;
 		if (maxX > buffer.width) maxX = buffer.width;
-		if (maxY > buffer.width) maxY = buffer.width;
+		if (maxY > buffer.height) maxY = buffer.height;
+
+		uint32_t raw_color = pack(color);
 
-		uint32_t raw_color = (color.red << 16) | (color.green << 8) | (color.blue << 0);
+		if (minX >= maxX)
+			return;
 
 		uint8_t* row = (uint8_t*)buffer.memory + minX * bytes_per_pixel + minY * buffer.pitch;
 		for (int y = minY; y < maxY; y++) {
 
-			uint32_t* pixel = (uint32_t*)row;
+			fillRow((uint32_t*)row, maxX - minX, raw_color);
+
+			row += buffer.pitch;
 
-			for (int x = minX; x < maxX; x++) {
+		}
 
-				*pixel++ = raw_color;
+	}
+
+	void Renderer::DrawImage(const Image& image, int x, int y, BlendMode mode, int flip) {
+		DrawImage(image, { 0, 0, image.width, image.height }, { x, y, image.width, image.height }, mode, flip);
+	}
+
+	void Renderer::DrawImage(const Image& image, const Rect& source, const Rect& dest, BlendMode mode, int flip) {
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		// clip the source to the image
+		int sourceX = std::max(source.x, 0);
+		int sourceY = std::max(source.y, 0);
+		int sourceWidth = std::min(source.x + source.width, image.width) - sourceX;
+		int sourceHeight = std::min(source.y + source.height, image.height) - sourceY;
+		if (sourceWidth <= 0 || sourceHeight <= 0 || dest.width <= 0 || dest.height <= 0)
+			return;
+
+		// clip the destination to the buffer
+		int minX = std::max(dest.x, 0);
+		int minY = std::max(dest.y, 0);
+		int maxX = std::min(dest.x + dest.width, buffer.width);
+		int maxY = std::min(dest.y + dest.height, buffer.height);
+		if (minX >= maxX || minY >= maxY)
+			return;
+
+		markDirty({ minX, minY, maxX - minX, maxY - minY });
+
+		// 16.16 source steps per destination pixel, sampled at pixel centers
+		int64_t stepX = ((int64_t)sourceWidth << 16) / dest.width;
+		int64_t stepY = ((int64_t)sourceHeight << 16) / dest.height;
+
+		// images are BGRX ordered; an RGBA buffer takes them swizzled
+		bool swizzle = buffer.format == PixelFormat::RGBA;
+		bool direct = sourceWidth == dest.width && !(flip & FLIP_X) && !swizzle;
+		uint32_t colorKey = image.colorKey;
+		if (swizzle)
+			swizzleRow(&colorKey, &colorKey, 1);
+
+		// scaled, mirrored and swizzled rows are gathered here first, a chunk at a time
+		const int chunkSize = 256;
+		uint32_t span[chunkSize];
+
+		uint8_t* row = (uint8_t*)buffer.memory + minY * buffer.pitch;
+		for (int y = minY; y < maxY; y++) {
+			int sy = (int)(((y - dest.y) * stepY + (stepY >> 1)) >> 16);
+			if (flip & FLIP_Y)
+				sy = sourceHeight - 1 - sy;
+			const uint32_t* sourceRow = image.row(sourceY + sy) + sourceX;
+			uint32_t* target = (uint32_t*)row;
 
+			if (direct) {
+				blitRow(target + minX, sourceRow + (minX - dest.x), maxX - minX, mode, colorKey);
+			}
+			else {
+				for (int x = minX; x < maxX; x += chunkSize) {
+					int count = std::min(chunkSize, maxX - x);
+					for (int i = 0; i < count; i++) {
+						int sx = (int)(((x + i - dest.x) * stepX + (stepX >> 1)) >> 16);
+						span[i] = sourceRow[(flip & FLIP_X) ? sourceWidth - 1 - sx : sx];
+					}
+					if (swizzle)
+						swizzleRow(span, span, count);
+					blitRow(target + x, span, count, mode, colorKey);
+				}
 			}
 
 			row += buffer.pitch;
+		}
+	}
+
+	void Renderer::fillSpan(int y, int x0, int x1, uint32_t color) {
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		if (y < 0 || y >= buffer.height)
+			return;
+
+		x0 = std::max(x0, 0);
+		x1 = std::min(x1, buffer.width - 1);
+		if (x0 > x1)
+			return;
 
+		uint32_t* row = (uint32_t*)((uint8_t*)buffer.memory + y * buffer.pitch);
+		fillRow(row + x0, x1 - x0 + 1, color);
+	}
+
+	// the part t0 .. t1 (of 0 .. 1) of the segment inside minX .. maxX, minY .. maxY
+	// (Liang-Barsky), false when none of it is
+	static bool clipSegment(double x0, double y0, double x1, double y1, double minX, double minY, double maxX, double maxY, double& outT0, double& outT1) {
+		double dx = x1 - x0, dy = y1 - y0;
+		const double p[4] = { -dx, dx, -dy, dy };
+		const double q[4] = { x0 - minX, maxX - x0, y0 - minY, maxY - y0 };
+
+		double t0 = 0, t1 = 1;
+		for (int i = 0; i < 4; i++) {
+			if (p[i] == 0) {
+				if (q[i] < 0)
+					return false;
+			}
+			else if (p[i] < 0) {
+				t0 = std::max(t0, q[i] / p[i]);
+			}
+			else {
+				t1 = std::min(t1, q[i] / p[i]);
+			}
 		}
+		if (t0 > t1)
+			return false;
+
+		outT0 = t0;
+		outT1 = t1;
+		return true;
+	}
+
+	void Renderer::DrawLine(int x0, int y0, int x1, int y1, const RGBColor& color) {
+		Renderer& renderer = getInstance();
+		BitmapBuffer& buffer = renderer.buffer;
+		uint32_t raw_color = pack(color);
+
+		if (renderer.antiAliasing) {
+			// a one pixel wide quad through the end pixel centers, reaching half a
+			// pixel past them like the aliased line's end pixels do
+			float ax = x0 + 0.5f, ay = y0 + 0.5f, bx = x1 + 0.5f, by = y1 + 0.5f;
+			float dx = bx - ax, dy = by - ay;
+			float length = sqrtf(dx * dx + dy * dy);
+			if (length == 0) {
+				dx = 1;
+				dy = 0;
+			}
+			else {
+				dx /= length;
+				dy /= length;
+			}
+
+			float ux = dx * 0.5f, uy = dy * 0.5f; // half a pixel along the line
+			float nx = -uy, ny = ux;               // and across it
+			addEdge(ax - ux + nx, ay - uy + ny, bx + ux + nx, by + uy + ny);
+			addEdge(bx + ux + nx, by + uy + ny, bx + ux - nx, by + uy - ny);
+			addEdge(bx + ux - nx, by + uy - ny, ax - ux - nx, ay - uy - ny);
+			addEdge(ax - ux - nx, ay - uy - ny, ax - ux + nx, ay - uy + ny);
+			fillEdges(raw_color);
+			return;
+		}
+
+		markDirty({ std::min(x0, x1), std::min(y0, y1), abs(x1 - x0) + 1, abs(y1 - y0) + 1 });
+
+		int dx = abs(x1 - x0), dy = abs(y1 - y0);
+		int stepX = x0 < x1 ? 1 : -1;
+		int stepY = y0 < y1 ? 1 : -1;
+
+		// steps along the major axis; a line leaving the buffer only walks the
+		// steps inside it (with a pixel to spare for rounding), but from the
+		// state the unclipped line has there so both put the same pixels
+		int major = std::max(dx, dy);
+		int first = 0, last = major;
+		if (std::min(x0, x1) < 0 || std::max(x0, x1) >= buffer.width || std::min(y0, y1) < 0 || std::max(y0, y1) >= buffer.height) {
+			double t0, t1;
+			if (!clipSegment(x0, y0, x1, y1, -0.5, -0.5, buffer.width - 0.5, buffer.height - 0.5, t0, t1))
+				return;
+
+			first = std::max((int)floor(t0 * major) - 1, 0);
+			last = std::min((int)ceil(t1 * major) + 1, major);
+		}
+
+		// Bresenham; an x major line's pixels on one row go out as one span.
+		// after k steps the minor axis has moved m = round(k * minor / major),
+		// halves rounding down, and the error is 2 minor (k + 1) - major (2m + 1)
+		if (dx >= dy) {
+			int64_t minor = dx ? (2 * (int64_t)first * dy + dx - 1) / (2 * (int64_t)dx) : 0;
+			int64_t error = 2 * (int64_t)dy * (first + 1) - (int64_t)dx * (2 * minor + 1);
+			int y = y0 + (int)minor * stepY;
+			int x = x0 + first * stepX;
+			int xEnd = x0 + last * stepX;
+			int spanStart = x;
+			for (; ; x += stepX) {
+				if (x == xEnd) {
+					fillSpan(y, std::min(spanStart, x), std::max(spanStart, x), raw_color);
+					break;
+				}
+				if (error > 0) {
+					fillSpan(y, std::min(spanStart, x), std::max(spanStart, x), raw_color);
+					spanStart = x + stepX;
+					y += stepY;
+					error -= 2 * dx;
+				}
+				error += 2 * dy;
+			}
+		}
+		else {
+			int64_t minor = (2 * (int64_t)first * dx + dy - 1) / (2 * (int64_t)dy);
+			int64_t error = 2 * (int64_t)dx * (first + 1) - (int64_t)dy * (2 * minor + 1);
+			int x = x0 + (int)minor * stepX;
+			int y = y0 + first * stepY;
+			int yEnd = y0 + last * stepY;
+			for (; ; y += stepY) {
+				fillSpan(y, x, x, raw_color);
+				if (y == yEnd)
+					break;
+				if (error > 0) {
+					x += stepX;
+					error -= 2 * dy;
+				}
+				error += 2 * dx;
+			}
+		}
+	}
 
+	void Renderer::DrawCircle(int centerX, int centerY, int radius, const RGBColor& color) {
+		DrawEllipse(centerX, centerY, radius, radius, color);
+	}
+
+	void Renderer::FillCircle(int centerX, int centerY, int radius, const RGBColor& color) {
+		FillEllipse(centerX, centerY, radius, radius, color);
+	}
+
+	void Renderer::DrawEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color) {
+		if (radiusX < 0 || radiusY < 0)
+			return;
+
+		if (getInstance().antiAliasing) {
+			// a one pixel wide ring around the aliased outline's pixel centers
+			float x = centerX + 0.5f, y = centerY + 0.5f;
+			addEllipseEdges(x, y, radiusX + 0.5f, radiusY + 0.5f, false);
+			if (radiusX > 0 && radiusY > 0)
+				addEllipseEdges(x, y, radiusX - 0.5f, radiusY - 0.5f, true);
+			fillEdges(pack(color));
+			return;
+		}
+
+		markDirty({ centerX - radiusX, centerY - radiusY, 2 * radiusX + 1, 2 * radiusY + 1 });
+		ellipseSpans(centerX, centerY, radiusX, radiusY, false, pack(color));
+	}
+
+	void Renderer::FillEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color) {
+		if (radiusX < 0 || radiusY < 0)
+			return;
+
+		if (getInstance().antiAliasing) {
+			addEllipseEdges(centerX + 0.5f, centerY + 0.5f, radiusX + 0.5f, radiusY + 0.5f, false);
+			fillEdges(pack(color));
+			return;
+		}
+
+		markDirty({ centerX - radiusX, centerY - radiusY, 2 * radiusX + 1, 2 * radiusY + 1 });
+		ellipseSpans(centerX, centerY, radiusX, radiusY, true, pack(color));
+	}
+
+	void Renderer::ellipseSpans(int centerX, int centerY, int radiusX, int radiusY, bool filled, uint32_t color) {
+		// half width of every row above the center; the extra row stays empty
+		// so the outline's top row comes out whole
+		std::vector<int>& halfWidths = getInstance().halfWidths;
+		halfWidths.assign(radiusY + 2, -1);
+
+		if (radiusX == 0 || radiusY == 0) {
+			for (int y = 0; y <= radiusY; y++)
+				halfWidths[y] = radiusX;
+		}
+		else {
+			// midpoint ellipse, decisions scaled by 4 to stay integral
+			int64_t rx2 = (int64_t)radiusX * radiusX, ry2 = (int64_t)radiusY * radiusY;
+			int64_t x = 0, y = radiusY;
+			int64_t px = 0, py = 2 * rx2 * y;
+
+			int64_t decision = 4 * ry2 - 4 * rx2 * radiusY + rx2;
+			while (px < py) {
+				halfWidths[y] = std::max(halfWidths[y], (int)x);
+				x++;
+				px += 2 * ry2;
+				if (decision < 0) {
+					decision += 4 * (ry2 + px);
+				}
+				else {
+					y--;
+					py -= 2 * rx2;
+					decision += 4 * (ry2 + px - py);
+				}
+			}
+
+			decision = ry2 * (2 * x + 1) * (2 * x + 1) + 4 * rx2 * (y - 1) * (y - 1) - 4 * rx2 * ry2;
+			while (y >= 0) {
+				halfWidths[y] = std::max(halfWidths[y], (int)x);
+				y--;
+				py -= 2 * rx2;
+				if (decision > 0) {
+					decision += 4 * (rx2 - py);
+				}
+				else {
+					x++;
+					px += 2 * ry2;
+					decision += 4 * (rx2 - py + px);
+				}
+			}
+		}
+
+		for (int y = 0; y <= radiusY; y++) {
+			int outer = halfWidths[y];
+			// an outline row reaches in to where the next row out ends
+			int inner = filled ? 0 : std::min(halfWidths[y + 1] + 1, outer);
+
+			for (int row = centerY - y; ; row = centerY + y) {
+				if (inner == 0) {
+					fillSpan(row, centerX - outer, centerX + outer, color);
+				}
+				else {
+					fillSpan(row, centerX - outer, centerX - inner, color);
+					fillSpan(row, centerX + inner, centerX + outer, color);
+				}
+				if (y == 0 || row == centerY + y)
+					break;
+			}
+		}
+	}
+
+	void Renderer::FillPolygon(const Point* points, int count, const RGBColor& color) {
+		if (count < 3)
+			return;
+
+		for (int i = 0; i < count; i++) {
+			const Point& a = points[i];
+			const Point& b = points[(i + 1) % count];
+			addEdge(a.x + 0.5f, a.y + 0.5f, b.x + 0.5f, b.y + 0.5f);
+		}
+
+		fillEdges(pack(color));
+	}
+
+	void Renderer::addEdge(float x0, float y0, float x1, float y1) {
+		if (y0 == y1)
+			return;
+
+		int winding = 1;
+		if (y0 > y1) {
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+			winding = -1;
+		}
+
+		getInstance().edges.push_back({ y0, y1, x0, (x1 - x0) / (y1 - y0), winding });
+	}
+
+	void Renderer::addEllipseEdges(float centerX, float centerY, float radiusX, float radiusY, bool reversed) {
+		// enough segments to keep every chord within an eighth of a pixel of the curve
+		float radius = std::max(radiusX, radiusY);
+		float cosine = std::max(1.0f - 0.125f / std::max(radius, 0.125f), -1.0f);
+		int segments = std::min(std::max((int)ceilf(3.14159265f / acosf(cosine)), 8), 1024);
+
+		float lastX = centerX + radiusX, lastY = centerY;
+		for (int i = 1; i <= segments; i++) {
+			float angle = 6.28318531f * i / segments;
+			float x = centerX + radiusX * cosf(angle);
+			float y = centerY + radiusY * sinf(angle);
+			if (reversed)
+				addEdge(x, y, lastX, lastY);
+			else
+				addEdge(lastX, lastY, x, y);
+			lastX = x;
+			lastY = y;
+		}
+	}
+
+	void Renderer::fillEdges(uint32_t color) {
+		Renderer& renderer = getInstance();
+		BitmapBuffer& buffer = renderer.buffer;
+		std::vector<Edge>& edges = renderer.edges;
+
+		if (edges.empty())
+			return;
+
+		// bounds of the shape, clipped to the buffer
+		float shapeMinX = edges[0].xTop, shapeMaxX = edges[0].xTop;
+		float shapeMinY = edges[0].yTop, shapeMaxY = edges[0].yBottom;
+		for (const Edge& edge : edges) {
+			float xBottom = edge.xTop + (edge.yBottom - edge.yTop) * edge.dxdy;
+			shapeMinX = std::min(shapeMinX, std::min(edge.xTop, xBottom));
+			shapeMaxX = std::max(shapeMaxX, std::max(edge.xTop, xBottom));
+			shapeMinY = std::min(shapeMinY, edge.yTop);
+			shapeMaxY = std::max(shapeMaxY, edge.yBottom);
+		}
+
+		int minX = (int)std::max(floorf(shapeMinX), 0.0f);
+		int minY = (int)std::max(floorf(shapeMinY), 0.0f);
+		int maxX = (int)std::min(ceilf(shapeMaxX), (float)buffer.width);
+		int maxY = (int)std::min(ceilf(shapeMaxY), (float)buffer.height);
+		if (minX >= maxX || minY >= maxY) {
+			edges.clear();
+			return;
+		}
+
+		markDirty({ minX, minY, maxX - minX, maxY - minY });
+
+		std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.yTop < b.yTop; });
+
+		std::vector<Edge>& active = renderer.activeEdges;
+		std::vector<std::pair<float, int>>& crossings = renderer.crossings;
+		active.clear();
+		size_t nextEdge = 0;
+
+		// coverage takes four sample rows per pixel row and sums exact horizontal
+		// coverage per sample row: area holds the partly covered end pixels and
+		// cover the differences of the fully covered runs between them
+		bool antiAliased = renderer.antiAliasing;
+		const int samples = antiAliased ? 4 : 1;
+		const float sampleWeight = 256.0f / samples;
+		int width = maxX - minX;
+		int32_t* area = nullptr;
+		int32_t* cover = nullptr;
+		if (antiAliased) {
+			renderer.coverage.resize(2 * (size_t)(width + 1));
+			area = renderer.coverage.data();
+			cover = area + width + 1;
+		}
+
+		for (int y = minY; y < maxY; y++) {
+			uint32_t* row = (uint32_t*)((uint8_t*)buffer.memory + y * buffer.pitch);
+
+			if (antiAliased)
+				std::fill(renderer.coverage.begin(), renderer.coverage.end(), 0);
+
+			for (int sample = 0; sample < samples; sample++) {
+				float sampleY = y + (sample + 0.5f) / samples;
+
+				// active edge table: edges whose span of rows holds sampleY
+				while (nextEdge < edges.size() && edges[nextEdge].yTop <= sampleY)
+					active.push_back(edges[nextEdge++]);
+				active.erase(std::remove_if(active.begin(), active.end(), [&](const Edge& edge) { return edge.yBottom <= sampleY; }), active.end());
+
+				crossings.clear();
+				for (const Edge& edge : active)
+					crossings.push_back({ edge.xTop + (sampleY - edge.yTop) * edge.dxdy, edge.winding });
+				std::sort(crossings.begin(), crossings.end());
+
+				int winding = 0;
+				for (size_t i = 0; i + 1 < crossings.size(); i++) {
+					winding += crossings[i].second;
+					if (winding == 0)
+						continue;
+
+					float left = crossings[i].first, right = crossings[i + 1].first;
+
+					if (!antiAliased) {
+						// pixels whose centers are inside
+						int x0 = std::max((int)ceilf(left - 0.5f), minX);
+						int x1 = std::min((int)ceilf(right - 0.5f), maxX);
+						if (x0 < x1)
+							fillRow(row + x0, x1 - x0, color);
+						continue;
+					}
+
+					float a = std::max(left, (float)minX) - minX;
+					float b = std::min(right, (float)maxX) - minX;
+					if (a >= b)
+						continue;
+
+					int ia = (int)a, ib = (int)b;
+					if (ia == ib) {
+						area[ia] += (int32_t)((b - a) * sampleWeight + 0.5f);
+					}
+					else {
+						area[ia] += (int32_t)((ia + 1 - a) * sampleWeight + 0.5f);
+						cover[ia + 1] += (int32_t)sampleWeight;
+						cover[ib] -= (int32_t)sampleWeight;
+						if (ib < width)
+							area[ib] += (int32_t)((b - ib) * sampleWeight + 0.5f);
+					}
+				}
+			}
+
+			if (antiAliased) {
+				int32_t running = 0;
+				for (int x = 0; x < width; x++) {
+					running += cover[x];
+					area[x] += running;
+				}
+				coverageRow(row + minX, area, width, color);
+			}
+		}
+
+		edges.clear();
+	}
+
+	void Renderer::DrawString(const Font& font, const char* text, int x, int y, const RGBColor& color) {
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		const Font::ShapedText& shaped = font.shape(text);
+		if (shaped.glyphs.empty())
+			return;
+
+		int minX = std::max(x, 0);
+		int minY = std::max(y, 0);
+		int maxX = std::min(x + shaped.width, buffer.width);
+		int maxY = std::min(y + shaped.height, buffer.height);
+		if (minX >= maxX || minY >= maxY)
+			return;
+
+		markDirty({ minX, minY, maxX - minX, maxY - minY });
+
+		uint32_t raw_color = pack(color);
+		for (const Font::Glyph& glyph : shaped.glyphs) {
+			int glyphX = x + glyph.x;
+			int glyphY = y + glyph.y;
+			int x0 = std::max(glyphX, 0);
+			int y0 = std::max(glyphY, 0);
+			int x1 = std::min(glyphX + font.glyphWidth, buffer.width);
+			int y1 = std::min(glyphY + font.glyphHeight, buffer.height);
+			if (x0 >= x1 || y0 >= y1)
+				continue;
+
+			uint8_t* row = (uint8_t*)buffer.memory + y0 * buffer.pitch;
+			for (int py = y0; py < y1; py++) {
+				tintRow((uint32_t*)row + x0, font.glyphRow(glyph.index, py - glyphY) + (x0 - glyphX), x1 - x0, raw_color);
+				row += buffer.pitch;
+			}
+		}
+	}
+
+	void SpriteBatch::draw(const Image& image, int x, int y, int layer, BlendMode mode, int flip) {
+		draw(image, { 0, 0, image.width, image.height }, { x, y, image.width, image.height }, layer, mode, flip);
+	}
+
+	void SpriteBatch::draw(const Image& image, const Rect& source, const Rect& dest, int layer, BlendMode mode, int flip) {
+		sprites.push_back({ &image, source, dest, mode, flip, layer, (uint32_t)sprites.size() });
+	}
+
+	void SpriteBatch::flush() {
+		std::sort(sprites.begin(), sprites.end(), [](const Sprite& a, const Sprite& b) {
+			if (a.layer != b.layer) return a.layer < b.layer;
+			if (a.image != b.image) return std::less<const Image*>()(a.image, b.image);
+			return a.order < b.order;
+		});
+
+		for (const Sprite& sprite : sprites)
+			Renderer::DrawImage(*sprite.image, sprite.source, sprite.dest, sprite.mode, sprite.flip);
+
+		sprites.clear();
 	}
 
 	void Renderer::getWindowDimensions(int* outWidth, int* outHeight) {
+#if defined(FRAME_PLATFORM_WIN32)
 		RECT clientRect;
 		GetClientRect(getInstance().windowHandle, &clientRect);
 
 		*outWidth = clientRect.right - clientRect.left;
 		*outHeight = clientRect.bottom - clientRect.top;
+#else
+		*outWidth = getInstance().buffer.width;
+		*outHeight = getInstance().buffer.height;
+#endif
 	}
 
 	void Renderer::resizeFrameBuffer(int width, int height) {
 		BitmapBuffer& buffer = getInstance().buffer;
 
-		if (buffer.memory) {
-			VirtualFree(buffer.memory, 0, MEM_RELEASE);
+		if (buffer.memory && !buffer.external) {
+			Platform::freeFrameBuffer(buffer.memory);
 		}
 
 		buffer.width = width;
 		buffer.height = height;
+		buffer.format = PixelFormat::BGRX;
+		buffer.external = false;
 
+		buffer.pitch = buffer.width * bytes_per_pixel;
+		buffer.memory = Platform::allocateFrameBuffer(buffer.width, buffer.height, buffer.pitch);
+
+		describeBuffer();
+
+		// nothing of the new buffer has been cleared or presented yet
+		getInstance().drawnRegion.reset(true);
+		getInstance().erasedRegion.reset(true);
+	}
+
+	void Renderer::SetExternalBuffer(void* pixels, int width, int height, int pitch, PixelFormat format) {
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		if (buffer.memory && !buffer.external) {
+			Platform::freeFrameBuffer(buffer.memory);
+		}
+
+		buffer.width = width;
+		buffer.height = height;
+		buffer.memory = pixels;
+		buffer.pitch = pitch;
+		buffer.format = format;
+		buffer.external = true;
+
+		describeBuffer();
+
+		getInstance().drawnRegion.reset(true);
+		getInstance().erasedRegion.reset(true);
+	}
+
+	void Renderer::ReleaseExternalBuffer() {
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		if (buffer.external)
+			resizeFrameBuffer(buffer.width, buffer.height);
+	}
+
+	void Renderer::describeBuffer() {
+#if defined(FRAME_PLATFORM_WIN32)
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		// a DIB has no pitch of its own, rows are width * 4 bytes apart
+		buffer.info.bmiHeader = {};
 		buffer.info.bmiHeader.biSize = sizeof(buffer.info.bmiHeader);
 		buffer.info.bmiHeader.biWidth = buffer.width;
 		buffer.info.bmiHeader.biHeight = -(buffer.height);
 		buffer.info.bmiHeader.biPlanes = 1;
 		buffer.info.bmiHeader.biBitCount = 32;
-		buffer.info.bmiHeader.biCompression = BI_RGB;
 
-		int bufferMemorySize = buffer.width * buffer.height * bytes_per_pixel;
-		buffer.memory = VirtualAlloc(0, bufferMemorySize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
-		buffer.pitch = buffer.width * bytes_per_pixel;
+		if (buffer.format == PixelFormat::RGBA) {
+			// GDI reads the channels where the masks say, so RGBA needs no conversion
+			buffer.info.bmiHeader.biCompression = BI_BITFIELDS;
+			buffer.info.masks[0] = 0x000000FF;
+			buffer.info.masks[1] = 0x0000FF00;
+			buffer.info.masks[2] = 0x00FF0000;
+		}
+		else {
+			buffer.info.bmiHeader.biCompression = BI_RGB;
+		}
+#endif
+	}
+
+	void Renderer::CopyPixels(const void* pixels, int width, int height, int pitch, PixelFormat format, int x, int y, int tileSize) {
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		int minX = std::max(x, 0);
+		int minY = std::max(y, 0);
+		int maxX = std::min(x + width, buffer.width);
+		int maxY = std::min(y + height, buffer.height);
+		if (minX >= maxX || minY >= maxY)
+			return;
+
+		markDirty({ minX, minY, maxX - minX, maxY - minY });
+
+		bool convert = format != buffer.format;
+		int tilesX = tileSize ? (width + tileSize - 1) / tileSize : 0;
+
+		uint8_t* row = (uint8_t*)buffer.memory + minY * buffer.pitch;
+		for (int targetY = minY; targetY < maxY; targetY++) {
+			int sourceY = targetY - y;
+			uint32_t* target = (uint32_t*)row;
+
+			// one run per stretch of source pixels that are contiguous in memory:
+			// the whole row, or a tile row
+			for (int targetX = minX; targetX < maxX;) {
+				int sourceX = targetX - x;
+				const uint32_t* source;
+				int count;
+				if (tileSize) {
+					int tile = (sourceY / tileSize) * tilesX + sourceX / tileSize;
+					source = (const uint32_t*)pixels + (size_t)tile * tileSize * tileSize + (sourceY % tileSize) * tileSize + sourceX % tileSize;
+					count = std::min(tileSize - sourceX % tileSize, maxX - targetX);
+				}
+				else {
+					source = (const uint32_t*)((const uint8_t*)pixels + (size_t)sourceY * pitch) + sourceX;
+					count = maxX - targetX;
+				}
+
+				if (convert)
+					swizzleRow(target + targetX, source, count);
+				else
+					copyRow(target + targetX, source, count);
+
+				targetX += count;
+			}
+
+			row += buffer.pitch;
+		}
+	}
+
+	Renderer::DirtyRegion Renderer::takeChangedRegion(int windowWidth, int windowHeight) {
+		Renderer& renderer = getInstance();
+		BitmapBuffer& buffer = renderer.buffer;
+
+		// what changed on screen is what the last clear erased plus what was drawn since
+		DirtyRegion changed = renderer.erasedRegion;
+		for (const Rect& rect : renderer.drawnRegion.rects)
+			changed.add(rect, buffer.width, buffer.height);
+		changed.full = changed.full || renderer.drawnRegion.full;
+		renderer.erasedRegion.reset(false);
+
+		// a stretched copy rounds differently per rectangle, so it always goes whole
+		if (!renderer.dirtyTracking || buffer.external || windowWidth != buffer.width || windowHeight != buffer.height || exceedsThreshold(changed))
+			changed.reset(true);
+
+		return changed;
 	}
 
+#if defined(FRAME_PLATFORM_WIN32)
 	void Renderer::copyBufferToWindow(HDC deviceContext, int windowWidth, int windowHeight) {
 		BitmapBuffer& buffer = getInstance().buffer;
 
@@ -87,15 +975,113 @@ namespace frame{
 			0, 0, windowWidth, windowHeight,
 			0, 0, buffer.width, buffer.height,
 			buffer.memory,
-			&(buffer.info),
+			(const BITMAPINFO*)&(buffer.info),
 			DIB_RGB_COLORS,
 			SRCCOPY
 		);
 	}
 
-	void Renderer::clear() {
+	void Renderer::presentFrame(HDC deviceContext, int windowWidth, int windowHeight) {
 		BitmapBuffer& buffer = getInstance().buffer;
 
-		FillRectangle({ 0, 0, buffer.width, buffer.height }, getInstance().clearColor);
+		DirtyRegion changed = takeChangedRegion(windowWidth, windowHeight);
+		if (changed.full) {
+			copyBufferToWindow(deviceContext, windowWidth, windowHeight);
+			return;
+		}
+
+		// the source origin of a top-down DIB is its top left corner
+		for (const Rect& rect : changed.rects) {
+			StretchDIBits(
+				deviceContext,
+				rect.x, rect.y, rect.width, rect.height,
+				rect.x, rect.y, rect.width, rect.height,
+				buffer.memory,
+				(const BITMAPINFO*)&(buffer.info),
+				DIB_RGB_COLORS,
+				SRCCOPY
+			);
+		}
+	}
+#else
+	void Renderer::presentFrame(int windowWidth, int windowHeight) {
+		BitmapBuffer& buffer = getInstance().buffer;
+
+		DirtyRegion changed = takeChangedRegion(windowWidth, windowHeight);
+		Platform::presentSurface(buffer.memory, buffer.width, buffer.height, buffer.pitch, buffer.format, changed.rects, changed.full);
+	}
+#endif
+
+	void Renderer::clear() {
+		Renderer& renderer = getInstance();
+		BitmapBuffer& buffer = renderer.buffer;
+
+		// an external buffer is cleared by its owner
+		if (buffer.external) {
+			renderer.drawnRegion.reset(false);
+			return;
+		}
+
+		// everything else still holds the clear color from earlier frames
+		if (!renderer.dirtyTracking || exceedsThreshold(renderer.drawnRegion)) {
+			fill({ 0, 0, buffer.width, buffer.height }, renderer.clearColor);
+			renderer.erasedRegion.reset(true);
+		}
+		else {
+			for (const Rect& rect : renderer.drawnRegion.rects)
+				fill(rect, renderer.clearColor);
+			renderer.erasedRegion = renderer.drawnRegion;
+		}
+
+		renderer.drawnRegion.reset(false);
+	}
+
+	bool Renderer::exceedsThreshold(const DirtyRegion& region) {
+		const BitmapBuffer& buffer = getInstance().buffer;
+		return region.full || region.area > (int64_t)(getInstance().fullFrameThreshold * buffer.width * buffer.height);
+	}
+
+	void Renderer::DirtyRegion::add(const Rect& rect, int width, int height) {
+		if (full)
+			return;
+
+		int minX = std::max(rect.x, 0);
+		int minY = std::max(rect.y, 0);
+		int maxX = std::min(rect.x + rect.width, width);
+		int maxY = std::min(rect.y + rect.height, height);
+		if (minX >= maxX || minY >= maxY)
+			return;
+
+		// absorb every rect whose bounding union covers no more pixels than the two
+		// of them apart, i.e. overlapping or adjacent ones
+		for (size_t i = 0; i < rects.size();) {
+			const Rect& other = rects[i];
+			int unionMinX = std::min(minX, other.x);
+			int unionMinY = std::min(minY, other.y);
+			int unionMaxX = std::max(maxX, other.x + other.width);
+			int unionMaxY = std::max(maxY, other.y + other.height);
+			int64_t unionArea = (int64_t)(unionMaxX - unionMinX) * (unionMaxY - unionMinY);
+			int64_t otherArea = (int64_t)other.width * other.height;
+
+			if (unionArea <= (int64_t)(maxX - minX) * (maxY - minY) + otherArea) {
+				minX = unionMinX;
+				minY = unionMinY;
+				maxX = unionMaxX;
+				maxY = unionMaxY;
+				area -= otherArea;
+				rects[i] = rects.back();
+				rects.pop_back();
+				i = 0;
+			}
+			else {
+				i++;
+			}
+		}
+
+		rects.push_back({ minX, minY, maxX - minX, maxY - minY });
+		area += (int64_t)(maxX - minX) * (maxY - minY);
+
+		if (rects.size() > maxRects)
+			reset(true);
 	}
 }
\ No newline at end of file
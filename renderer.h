@@ -1,7 +1,10 @@
 #pragma once
 
-#include <windows.h>
+#include "platform.h"
 #include <stdint.h>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace frame{
 
@@ -9,43 +12,187 @@ namespace frame{
 		uint8_t red, green, blue;
 	};
 
-	struct Rect {
-		int x, y, width, height;
+	struct Point {
+		int x, y;
+	};
+
+	class Font;
+
+	// 32-bit image in the frame buffer's pixel layout, 0xAARRGGBB. alpha is only
+	// read by alpha blended blits, colorKey (rgb) only by color keyed ones
+	struct Image {
+		int width = 0, height = 0;
+		std::vector<uint32_t> pixels;
+		uint32_t colorKey = 0xFF00FF;
+
+		Image() {}
+
+		// copies width * height pixels from argb when given, else starts transparent black
+		Image(int width, int height, const uint32_t* argb = nullptr);
+
+		inline uint32_t* row(int y) { return pixels.data() + (size_t)y * width; }
+		inline const uint32_t* row(int y) const { return pixels.data() + (size_t)y * width; }
+	};
+
+	enum class BlendMode {
+		Opaque,		// copies the source pixels
+		ColorKey,	// skips source pixels whose rgb is the image's colorKey
+		Alpha		// blends the source over the buffer by source alpha
+	};
+
+	// mirroring for blits, may be combined
+	enum BlitFlip {
+		FLIP_NONE = 0,
+		FLIP_X = 1,
+		FLIP_Y = 2
 	};
 
 	class Renderer {
+#if defined(FRAME_PLATFORM_WIN32)
 		friend LRESULT CALLBACK WindowCallBack(
 			HWND windowHandle,
 			UINT message,
 			WPARAM wParam,
 			LPARAM lParam
 		);
+#endif
 
 		friend class Game;
+		friend class DrawList;
+
+#if defined(FRAME_PLATFORM_WIN32)
+		// BITMAPINFO with room for the channel masks of BI_BITFIELDS
+		struct BitmapInfo {
+			BITMAPINFOHEADER bmiHeader;
+			DWORD masks[3];
+		};
+#endif
 
 		struct BitmapBuffer {
 			int width, height;
-			BITMAPINFO info;
+#if defined(FRAME_PLATFORM_WIN32)
+			BitmapInfo info;
+#endif
 			void* memory;
 			int pitch; // in bytes
+			PixelFormat format;
+			bool external; // memory belongs to whoever called SetExternalBuffer
 		};
 
 	private:
 		static const int bytes_per_pixel = 4;
 
+#if defined(FRAME_PLATFORM_WIN32)
 		HWND windowHandle = 0;
+#endif
 		BitmapBuffer buffer;
 		RGBColor clearColor;
 
+		// held while a frame is drawn and presented off the window thread,
+		// so WM_PAINT never copies a half drawn buffer
+		std::mutex bufferMutex;
+
+		// part of the buffer touched by draw calls, as a short list of coalesced
+		// rectangles; full once it is too fragmented to be worth tracking
+		struct DirtyRegion {
+			static const size_t maxRects = 32;
+
+			std::vector<Rect> rects;
+			int64_t area = 0; // upper bound, rects may overlap
+			bool full = true;
+
+			void add(const Rect& rect, int width, int height);
+
+			inline void reset(bool toFull) { rects.clear(); area = 0; full = toFull; }
+		};
+
+		// dirty rectangle tracking: clear only erases what the previous frame drew
+		// and present only copies what was erased or drawn since
+		bool dirtyTracking = true;
+		float fullFrameThreshold = 0.5f;
+		bool antiAliasing = false;
+		DirtyRegion drawnRegion;   // drawn since the last clear
+		DirtyRegion erasedRegion;  // drawn by the previous frame, erased by the last clear
+
+		// polygon edge of the shape being filled, top to bottom
+		struct Edge {
+			float yTop, yBottom;
+			float xTop, dxdy;
+			int winding; // +1 for edges running down, -1 for edges running up
+		};
+
+		// scratch of the shape fills, kept to avoid allocating per shape
+		std::vector<Edge> edges;
+		std::vector<Edge> activeEdges;
+		std::vector<std::pair<float, int>> crossings;
+		std::vector<int> halfWidths;
+		std::vector<int32_t> coverage;
+
 	public:
-		inline static void SetClearColor(const RGBColor& color) { getInstance().clearColor = color; }
+		inline static void SetClearColor(const RGBColor& color) {
+			getInstance().clearColor = color;
+			// the whole buffer takes the new color on the next clear
+			getInstance().drawnRegion.full = true;
+		}
+
+		// with tracking off every frame clears and presents the whole buffer
+		inline static void SetDirtyTracking(bool enabled) { getInstance().dirtyTracking = enabled; }
+
+		// fraction of the buffer above which clear and present fall back to the whole frame
+		inline static void SetFullFrameThreshold(float fraction) { getInstance().fullFrameThreshold = fraction; }
+
+		// draws text with the top left of its first line at x, y; '\n' starts a new
+		// line, characters the font lacks draw as '?'
+		static void DrawString(const Font& font, const char* text, int x, int y, const RGBColor& color);
+
+		// makes the given pixels the buffer, in place: draw calls write to them and
+		// presents show them with no copy, in either channel order. the owner
+		// clears them, so the game loop's clear skips them, and every present is
+		// whole since the renderer does not see the owner's writes. the Win32
+		// window needs pitch == width * 4. stays bound until ReleaseExternalBuffer
+		// or a resize
+		static void SetExternalBuffer(void* pixels, int width, int height, int pitch, PixelFormat format);
+
+		// goes back to a buffer of the renderer's own, of the same size
+		static void ReleaseExternalBuffer();
+
+		// copies width x height pixels to x, y of the buffer, clipped to it, and
+		// converts them only when the formats differ. with tileSize the pixels are
+		// stored in tileSize square tiles in row-major tile order and pitch is unused
+		static void CopyPixels(const void* pixels, int width, int height, int pitch, PixelFormat format, int x, int y, int tileSize = 0);
+
+		// with anti-aliasing on, lines, circles, ellipses and polygons blend their
+		// edge pixels by coverage instead of setting whole pixels
+		inline static void SetAntiAliasing(bool enabled) { getInstance().antiAliasing = enabled; }
 
 		static void SetPixel(int x, int y, const RGBColor& color);
 
 		static void FillRectangle(const Rect& rect, const RGBColor& color);
 
+		// one pixel wide, both end points included
+		static void DrawLine(int x0, int y0, int x1, int y1, const RGBColor& color);
+
+		static void DrawCircle(int centerX, int centerY, int radius, const RGBColor& color);
+
+		static void FillCircle(int centerX, int centerY, int radius, const RGBColor& color);
+
+		static void DrawEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color);
+
+		static void FillEllipse(int centerX, int centerY, int radiusX, int radiusY, const RGBColor& color);
+
+		// fills the pixels whose centers lie inside the polygon through the centers
+		// of the given pixels, by the nonzero winding rule
+		static void FillPolygon(const Point* points, int count, const RGBColor& color);
+
+		// blits the whole image with its top left corner at x, y, clipped to the buffer
+		static void DrawImage(const Image& image, int x, int y, BlendMode mode = BlendMode::Alpha, int flip = FLIP_NONE);
+
+		// blits the source rect of the image (clipped to the image) into dest, scaling
+		// with nearest neighbour sampling when the sizes differ
+		static void DrawImage(const Image& image, const Rect& source, const Rect& dest, BlendMode mode = BlendMode::Alpha, int flip = FLIP_NONE);
+
 	private:
-		Renderer() { buffer = {}; clearColor = { 255, 255, 255 }; }
+		Renderer() { buffer = {}; buffer.format = PixelFormat::BGRX; clearColor = { 255, 255, 255 }; }
 
 		Renderer(const Renderer&) = delete;
 		Renderer& operator= (const Renderer&) = delete;
@@ -58,15 +205,95 @@ namespace frame{
 		}
 
 	private:
+#if defined(FRAME_PLATFORM_WIN32)
 		inline static void setWindowHandle(HWND _windowHandle) { getInstance().windowHandle = _windowHandle; }
+#endif
 
+		// the client area on Win32, the buffer headless
 		static void getWindowDimensions(int* outWidth, int* outHeight);
 		
 		static void resizeFrameBuffer(int width, int height);
 
+#if defined(FRAME_PLATFORM_WIN32)
 		static void copyBufferToWindow(HDC deviceContext, int windowWidth, int windowHeight);
 
+		// copies the changed parts of the frame, or all of it, to the window
+		static void presentFrame(HDC deviceContext, int windowWidth, int windowHeight);
+#else
+		// hands the buffer and its changed parts to the headless surface, no copy
+		static void presentFrame(int windowWidth, int windowHeight);
+#endif
+
+		// what presentFrame has to show: the last clear's erasure plus what was
+		// drawn since; full when the whole frame should go
+		static DirtyRegion takeChangedRegion(int windowWidth, int windowHeight);
+
 		static void clear();
+
+		// color as a pixel in the buffer's format
+		inline static uint32_t pack(const RGBColor& color) {
+			if (getInstance().buffer.format == PixelFormat::RGBA)
+				return 0xFF000000 | (color.blue << 16) | (color.green << 8) | (color.red << 0);
+			return (color.red << 16) | (color.green << 8) | (color.blue << 0);
+		}
+
+		// sets up the bitmap header for the buffer's size and format
+		static void describeBuffer();
+
+		static void fill(const Rect& rect, const RGBColor& color);
+
+		// fills x0 .. x1 (inclusive) of row y, clipped to the buffer
+		static void fillSpan(int y, int x0, int x1, uint32_t color);
+
+		// outline (or filled) ellipse from its midpoint half widths
+		static void ellipseSpans(int centerX, int centerY, int radiusX, int radiusY, bool filled, uint32_t color);
+
+		// edges in buffer coordinates, pixel x, y covering x .. x + 1, y .. y + 1
+		static void addEdge(float x0, float y0, float x1, float y1);
+
+		static void addEllipseEdges(float centerX, float centerY, float radiusX, float radiusY, bool reversed);
+
+		// fills the collected edges by the nonzero rule, aliased or by coverage,
+		// and clears them
+		static void fillEdges(uint32_t color);
+
+		inline static void markDirty(const Rect& rect) {
+			Renderer& renderer = getInstance();
+			renderer.drawnRegion.add(rect, renderer.buffer.width, renderer.buffer.height);
+		}
+
+		static bool exceedsThreshold(const DirtyRegion& region);
+	};
+
+	// Deferred sprite list. draw only records the blit; flush blits everything
+	// sorted by layer and, within a layer, by image, so consecutive blits read the
+	// same source pixels. Sprites of one image keep their draw order, sprites of
+	// different images on one layer do not, so overlapping sprites of different
+	// images belong on different layers.
+	class SpriteBatch {
+	public:
+		void draw(const Image& image, int x, int y, int layer = 0, BlendMode mode = BlendMode::Alpha, int flip = FLIP_NONE);
+
+		void draw(const Image& image, const Rect& source, const Rect& dest, int layer = 0, BlendMode mode = BlendMode::Alpha, int flip = FLIP_NONE);
+
+		// draws the queued sprites and empties the batch; images must still be alive
+		void flush();
+
+		inline void clear() { sprites.clear(); }
+
+		inline size_t size() const { return sprites.size(); }
+
+	private:
+		struct Sprite {
+			const Image* image;
+			Rect source, dest;
+			BlendMode mode;
+			int flip;
+			int layer;
+			uint32_t order;
+		};
+
+		std::vector<Sprite> sprites;
 	};
 
 }
\ No newline at end of file
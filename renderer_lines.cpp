@@ -0,0 +1,95 @@
+// renderer_lines.cpp
+// Clipping check for Renderer::DrawLine. Draws random lines that leave a
+// small buffer and the same lines shifted into the middle of a buffer large
+// enough to hold them whole, then compares the small buffer with the same
+// region of the large one: a clipped line must put exactly the pixels the
+// unclipped line puts there.
+//
+// Build:
+//   g++ -std=c++17 -O2 -pthread renderer_lines.cpp renderer.cpp platform.cpp input.cpp text.cpp -o renderer_lines
+//
+// Usage:
+//   renderer_lines [--lines N] [--seed N]
+// The exit code is 0 when every line matches and 1 otherwise.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "renderer.h"
+
+static const int smallSize = 200;
+static const int inset = 400;
+static const int largeSize = smallSize + 2 * inset;
+
+struct Line {
+    int x0, y0, x1, y1;
+};
+
+// pixels of the line in the small buffer that the inset line does not put
+// at the same place of the large one, and the other way round
+static int compareLine(const Line& line, std::vector<uint32_t>& small, std::vector<uint32_t>& large) {
+    const frame::RGBColor white = { 255, 255, 255 };
+
+    std::fill(small.begin(), small.end(), 0);
+    frame::Renderer::SetExternalBuffer(small.data(), smallSize, smallSize, smallSize * 4, frame::PixelFormat::BGRX);
+    frame::Renderer::DrawLine(line.x0, line.y0, line.x1, line.y1, white);
+
+    std::fill(large.begin(), large.end(), 0);
+    frame::Renderer::SetExternalBuffer(large.data(), largeSize, largeSize, largeSize * 4, frame::PixelFormat::BGRX);
+    frame::Renderer::DrawLine(line.x0 + inset, line.y0 + inset, line.x1 + inset, line.y1 + inset, white);
+
+    frame::Renderer::ReleaseExternalBuffer();
+
+    int mismatches = 0;
+    for (int y = 0; y < smallSize; ++y) {
+        const uint32_t* row = large.data() + (size_t)(y + inset) * largeSize + inset;
+        for (int x = 0; x < smallSize; ++x)
+            mismatches += small[(size_t)y * smallSize + x] != row[x];
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    int lineCount = 20000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) lineCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--lines N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // lines that cross into the buffer at a shallow slope, the case rounding
+    // the clipped end points gets wrong, then random ones reaching up to the
+    // inset past every side
+    std::vector<Line> lines = {
+        { -7, 10, 30, 13 },
+        { 10, -7, 13, 30 },
+        { -350, 5, 550, 190 },
+        { 195, -300, 3, 500 }
+    };
+
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> coordinate(-inset, smallSize + inset - 1);
+    while ((int)lines.size() < lineCount)
+        lines.push_back({ coordinate(random), coordinate(random), coordinate(random), coordinate(random) });
+
+    std::vector<uint32_t> small((size_t)smallSize * smallSize);
+    std::vector<uint32_t> large((size_t)largeSize * largeSize);
+    int failures = 0;
+    for (const Line& line : lines) {
+        int mismatches = compareLine(line, small, large);
+        if (!mismatches) continue;
+
+        if (++failures <= 10)
+            printf("FAIL (%d,%d)-(%d,%d): %d pixels differ\n", line.x0, line.y0, line.x1, line.y1, mismatches);
+    }
+
+    printf("%d of %d lines differ\n", failures, (int)lines.size());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+#include "text.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+namespace frame {
+
+	// 5x7 glyphs of ' ' .. '~', five column masks each, bit 0 on top
+	static const uint8_t builtInGlyphs[95 * 5] = {
+		0x00, 0x00, 0x00, 0x00, 0x00, // ' '
+		0x00, 0x00, 0x5F, 0x00, 0x00, // !
+		0x00, 0x07, 0x00, 0x07, 0x00, // "
+		0x14, 0x7F, 0x14, 0x7F, 0x14, // #
+		0x24, 0x2A, 0x7F, 0x2A, 0x12, // $
+		0x23, 0x13, 0x08, 0x64, 0x62, // %
+		0x36, 0x49, 0x55, 0x22, 0x50, // &
+		0x00, 0x05, 0x03, 0x00, 0x00, // '
+		0x00, 0x1C, 0x22, 0x41, 0x00, // (
+		0x00, 0x41, 0x22, 0x1C, 0x00, // )
+		0x08, 0x2A, 0x1C, 0x2A, 0x08, // *
+		0x08, 0x08, 0x3E, 0x08, 0x08, // +
+		0x00, 0x50, 0x30, 0x00, 0x00, // ,
+		0x08, 0x08, 0x08, 0x08, 0x08, // -
+		0x00, 0x60, 0x60, 0x00, 0x00, // .
+		0x20, 0x10, 0x08, 0x04, 0x02, // /
+		0x3E, 0x51, 0x49, 0x45, 0x3E, // 0
+		0x00, 0x42, 0x7F, 0x40, 0x00, // 1
+		0x42, 0x61, 0x51, 0x49, 0x46, // 2
+		0x21, 0x41, 0x45, 0x4B, 0x31, // 3
+		0x18, 0x14, 0x12, 0x7F, 0x10, // 4
+		0x27, 0x45, 0x45, 0x45, 0x39, // 5
+		0x3C, 0x4A, 0x49, 0x49, 0x30, // 6
+		0x01, 0x71, 0x09, 0x05, 0x03, // 7
+		0x36, 0x49, 0x49, 0x49, 0x36, // 8
+		0x06, 0x49, 0x49, 0x29, 0x1E, // 9
+		0x00, 0x36, 0x36, 0x00, 0x00, // :
+		0x00, 0x56, 0x36, 0x00, 0x00, // ;
+		0x08, 0x14, 0x22, 0x41, 0x00, // <
+		0x14, 0x14, 0x14, 0x14, 0x14, // =
+		0x00, 0x41, 0x22, 0x14, 0x08, // >
+		0x02, 0x01, 0x51, 0x09, 0x06, // ?
+		0x32, 0x49, 0x79, 0x41, 0x3E, // @
+		0x7E, 0x11, 0x11, 0x11, 0x7E, // A
+		0x7F, 0x49, 0x49, 0x49, 0x36, // B
+		0x3E, 0x41, 0x41, 0x41, 0x22, // C
+		0x7F, 0x41, 0x41, 0x22, 0x1C, // D
+		0x7F, 0x49, 0x49, 0x49, 0x41, // E
+		0x7F, 0x09, 0x09, 0x09, 0x01, // F
+		0x3E, 0x41, 0x49, 0x49, 0x7A, // G
+		0x7F, 0x08, 0x08, 0x08, 0x7F, // H
+		0x00, 0x41, 0x7F, 0x41, 0x00, // I
+		0x20, 0x40, 0x41, 0x3F, 0x01, // J
+		0x7F, 0x08, 0x14, 0x22, 0x41, // K
+		0x7F, 0x40, 0x40, 0x40, 0x40, // L
+		0x7F, 0x02, 0x0C, 0x02, 0x7F, // M
+		0x7F, 0x04, 0x08, 0x10, 0x7F, // N
+		0x3E, 0x41, 0x41, 0x41, 0x3E, // O
+		0x7F, 0x09, 0x09, 0x09, 0x06, // P
+		0x3E, 0x41, 0x51, 0x21, 0x5E, // Q
+		0x7F, 0x09, 0x19, 0x29, 0x46, // R
+		0x46, 0x49, 0x49, 0x49, 0x31, // S
+		0x01, 0x01, 0x7F, 0x01, 0x01, // T
+		0x3F, 0x40, 0x40, 0x40, 0x3F, // U
+		0x1F, 0x20, 0x40, 0x20, 0x1F, // V
+		0x3F, 0x40, 0x38, 0x40, 0x3F, // W
+		0x63, 0x14, 0x08, 0x14, 0x63, // X
+		0x07, 0x08, 0x70, 0x08, 0x07, // Y
+		0x61, 0x51, 0x49, 0x45, 0x43, // Z
+		0x00, 0x7F, 0x41, 0x41, 0x00, // [
+		0x02, 0x04, 0x08, 0x10, 0x20, // backslash
+		0x00, 0x41, 0x41, 0x7F, 0x00, // ]
+		0x04, 0x02, 0x01, 0x02, 0x04, // ^
+		0x40, 0x40, 0x40, 0x40, 0x40, // _
+		0x00, 0x01, 0x02, 0x04, 0x00, // `
+		0x20, 0x54, 0x54, 0x54, 0x78, // a
+		0x7F, 0x48, 0x44, 0x44, 0x38, // b
+		0x38, 0x44, 0x44, 0x44, 0x20, // c
+		0x38, 0x44, 0x44, 0x48, 0x7F, // d
+		0x38, 0x54, 0x54, 0x54, 0x18, // e
+		0x08, 0x7E, 0x09, 0x01, 0x02, // f
+		0x0C, 0x52, 0x52, 0x52, 0x3E, // g
+		0x7F, 0x08, 0x04, 0x04, 0x78, // h
+		0x00, 0x44, 0x7D, 0x40, 0x00, // i
+		0x20, 0x40, 0x44, 0x3D, 0x00, // j
+		0x7F, 0x10, 0x28, 0x44, 0x00, // k
+		0x00, 0x41, 0x7F, 0x40, 0x00, // l
+		0x7C, 0x04, 0x18, 0x04, 0x78, // m
+		0x7C, 0x08, 0x04, 0x04, 0x78, // n
+		0x38, 0x44, 0x44, 0x44, 0x38, // o
+		0x7C, 0x14, 0x14, 0x14, 0x08, // p
+		0x08, 0x14, 0x14, 0x18, 0x7C, // q
+		0x7C, 0x08, 0x04, 0x04, 0x08, // r
+		0x48, 0x54, 0x54, 0x54, 0x20, // s
+		0x04, 0x3F, 0x44, 0x40, 0x20, // t
+		0x3C, 0x40, 0x40, 0x20, 0x7C, // u
+		0x1C, 0x20, 0x40, 0x20, 0x1C, // v
+		0x3C, 0x40, 0x30, 0x40, 0x3C, // w
+		0x44, 0x28, 0x10, 0x28, 0x44, // x
+		0x0C, 0x50, 0x50, 0x50, 0x3C, // y
+		0x44, 0x64, 0x54, 0x4C, 0x44, // z
+		0x00, 0x08, 0x36, 0x41, 0x00, // {
+		0x00, 0x00, 0x7F, 0x00, 0x00, // |
+		0x00, 0x41, 0x36, 0x08, 0x00, // }
+		0x10, 0x08, 0x08, 0x10, 0x08, // ~
+	};
+
+	Font::Font(const uint8_t* columnMasks, int columns, int rows, int first, int count, int scale)
+		: first(first), count(count) {
+		glyphWidth = columns * scale;
+		glyphHeight = rows * scale;
+		cellWidth = (columns + 1) * scale;
+		lineHeight = (rows + 1) * scale;
+
+		int atlasRows = (count + glyphsPerRow - 1) / glyphsPerRow;
+		atlasWidth = glyphsPerRow * glyphWidth;
+		atlas.assign((size_t)atlasWidth * atlasRows * glyphHeight, 0);
+
+		for (int index = 0; index < count; index++) {
+			const uint8_t* glyph = columnMasks + index * columns;
+			for (int y = 0; y < glyphHeight; y++) {
+				uint8_t* row = (uint8_t*)glyphRow(index, y);
+				for (int x = 0; x < glyphWidth; x++)
+					row[x] = (glyph[x / scale] >> (y / scale)) & 1 ? 255 : 0;
+			}
+		}
+	}
+
+	const Font& Font::builtIn(int scale) {
+		static const std::vector<Font> fonts = [] {
+			std::vector<Font> scaled;
+			scaled.reserve(4);
+			for (int scale = 1; scale <= 4; scale++)
+				scaled.emplace_back(builtInGlyphs, 5, 7, ' ', 95, scale);
+			return scaled;
+		}();
+
+		return fonts[std::min(std::max(scale, 1), 4) - 1];
+	}
+
+	void Font::measure(const char* text, int* outWidth, int* outHeight) const {
+		const ShapedText& shaped = shape(text);
+		*outWidth = shaped.width;
+		*outHeight = shaped.height;
+	}
+
+	const Font::ShapedText& Font::shape(const char* text) const {
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		size_t length = 0;
+		for (const char* c = text; *c; c++, length++)
+			hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+
+		ShapedText& shaped = cache[hash % cacheSize];
+		if (shaped.hash == hash && shaped.text.size() == length && memcmp(shaped.text.data(), text, length) == 0)
+			return shaped;
+
+		// the entry keeps its capacity, so a string that changes every frame
+		// stops allocating once it has been as long before
+		shaped.hash = hash;
+		shaped.text.assign(text, length);
+		shaped.glyphs.clear();
+
+		int x = 0, y = 0;
+		int width = 0;
+		for (size_t i = 0; i < length; i++) {
+			int character = (uint8_t)text[i];
+			if (character == '\n') {
+				width = std::max(width, x);
+				x = 0;
+				y += lineHeight;
+				continue;
+			}
+
+			int index = character - first;
+			if (index < 0 || index >= count)
+				index = '?' - first;
+
+			// blank glyphs take their cell without being drawn
+			if (character != ' ' && index >= 0 && index < count)
+				shaped.glyphs.push_back({ x, y, (uint32_t)index });
+			x += cellWidth;
+		}
+
+		// cells end in a blank column and row that the text does not need
+		width = std::max(width, x);
+		shaped.width = width > 0 ? width - (cellWidth - glyphWidth) : 0;
+		shaped.height = length > 0 ? y + glyphHeight : 0;
+		return shaped;
+	}
+
+	int formatInteger(char* out, int capacity, int64_t value) {
+		if (capacity <= 0)
+			return 0;
+
+		// digits come out backwards; the magnitude is taken unsigned so that
+		// the most negative value has one
+		char digits[20];
+		int digitCount = 0;
+		uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+		do {
+			digits[digitCount++] = (char)('0' + magnitude % 10);
+			magnitude /= 10;
+		} while (magnitude);
+
+		int length = 0;
+		if (value < 0 && length < capacity - 1)
+			out[length++] = '-';
+		while (digitCount && length < capacity - 1)
+			out[length++] = digits[--digitCount];
+		out[length] = 0;
+		return length;
+	}
+
+	int formatFloat(char* out, int capacity, double value, int decimals) {
+		if (capacity <= 0)
+			return 0;
+
+		decimals = std::min(std::max(decimals, 0), 9);
+
+		static const int64_t powers[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+		int64_t scale = powers[decimals];
+
+		const char* special = nullptr;
+		if (value != value)
+			special = "nan";
+		else if (fabs(value) * scale >= 9.0e18)
+			special = value < 0 ? "-inf" : "inf";
+
+		if (special) {
+			int length = 0;
+			while (special[length] && length < capacity - 1) {
+				out[length] = special[length];
+				length++;
+			}
+			out[length] = 0;
+			return length;
+		}
+
+		int64_t scaled = (int64_t)llround(fabs(value) * scale);
+		int length = 0;
+		// a value that rounds to zero keeps no sign
+		if (value < 0 && scaled != 0 && length < capacity - 1)
+			out[length++] = '-';
+		length += formatInteger(out + length, capacity - length, scaled / scale);
+
+		if (decimals > 0 && length < capacity - 1) {
+			out[length++] = '.';
+			int64_t fraction = scaled % scale;
+			for (int digit = decimals - 1; digit >= 0 && length < capacity - 1; digit--)
+				out[length++] = (char)('0' + fraction / powers[digit] % 10);
+			out[length] = 0;
+		}
+
+		return length;
+	}
+}
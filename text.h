@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace frame {
+
+	// Bitmap font rasterized once into a glyph atlas of coverage bytes, drawn
+	// with Renderer::DrawString. Strings are laid out in fixed cells and the
+	// layouts of recently drawn strings are cached: redrawing a string skips
+	// its layout, and strings that change every frame reuse the storage of the
+	// entry they replace instead of allocating. The cache makes a Font unsafe
+	// to draw from two threads at once.
+	class Font {
+		friend class Renderer;
+
+	public:
+		// glyphs first .. first + count - 1, each given as columns 8-bit column
+		// masks (bit 0 on top) of which the low rows bits are used, scaled up by
+		// a whole factor. cells leave one blank column and row between glyphs
+		Font(const uint8_t* columnMasks, int columns, int rows, int first, int count, int scale = 1);
+
+		// the built-in 5x7 printable ASCII font, scale 1 to 4
+		static const Font& builtIn(int scale = 1);
+
+		inline int getCellWidth() const { return cellWidth; }
+		inline int getLineHeight() const { return lineHeight; }
+
+		// size of the text as drawn, '\n' starting a new line
+		void measure(const char* text, int* outWidth, int* outHeight) const;
+
+	private:
+		struct Glyph {
+			int32_t x, y;	// top left, relative to the text's
+			uint32_t index;	// into the atlas
+		};
+
+		struct ShapedText {
+			uint64_t hash = 0;
+			std::string text;
+			std::vector<Glyph> glyphs;
+			int width = 0, height = 0;
+		};
+
+		static const int cacheSize = 64;
+
+		int first, count;
+		int glyphWidth, glyphHeight;
+		int cellWidth, lineHeight;
+
+		// glyphs in rows of glyphsPerRow, one coverage byte (0 .. 255) per pixel
+		static const int glyphsPerRow = 16;
+		int atlasWidth;
+		std::vector<uint8_t> atlas;
+
+		mutable ShapedText cache[cacheSize];
+
+	private:
+		// the layout of text, from the cache when it was drawn lately
+		const ShapedText& shape(const char* text) const;
+
+		inline const uint8_t* glyphRow(int index, int row) const {
+			int top = (index / glyphsPerRow) * glyphHeight + row;
+			return atlas.data() + (size_t)top * atlasWidth + (index % glyphsPerRow) * glyphWidth;
+		}
+	};
+
+	// writes value in decimal to out, NUL terminated and cut to fit capacity;
+	// returns the characters written. neither allocates
+	int formatInteger(char* out, int capacity, int64_t value);
+
+	// value rounded to decimals (0 .. 9) places; "nan", "inf" or "-inf" for
+	// values that are not finite or too large to print this way
+	int formatFloat(char* out, int capacity, double value, int decimals);
+
+	// Fixed capacity text built on the stack, for per-frame HUD lines.
+	// Appends past the capacity are cut off.
+	template <int Capacity>
+	class TextBuffer {
+	public:
+		TextBuffer() { text[0] = 0; }
+
+		inline TextBuffer& append(const char* string) {
+			while (*string && length < Capacity - 1)
+				text[length++] = *string++;
+			text[length] = 0;
+			return *this;
+		}
+
+		inline TextBuffer& append(int value) { return append((int64_t)value); }
+
+		inline TextBuffer& append(int64_t value) {
+			length += formatInteger(text + length, Capacity - length, value);
+			return *this;
+		}
+
+		inline TextBuffer& append(double value, int decimals = 2) {
+			length += formatFloat(text + length, Capacity - length, value, decimals);
+			return *this;
+		}
+
+		inline void clear() { length = 0; text[0] = 0; }
+
+		inline const char* c_str() const { return text; }
+		inline int size() const { return length; }
+
+	private:
+		char text[Capacity];
+		int length = 0;
+	};
+}
@@ -0,0 +1,106 @@
+// worker_pool.h
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads for data-parallel loops.
+// The calling thread takes part in every parallelFor, so a pool of N threads
+// keeps N + 1 cores busy.
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(int)>* task = nullptr;
+    int taskCount = 0;
+    std::atomic<int> nextIndex{0};
+    int activeWorkers = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    void runTasks() {
+        int index;
+        while ((index = nextIndex.fetch_add(1, std::memory_order_relaxed)) < taskCount) {
+            (*task)(index);
+        }
+    }
+
+    void workerLoop() {
+        unsigned seenGeneration = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+
+            runTasks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--activeWorkers == 0) doneCondition.notify_one();
+        }
+    }
+
+public:
+    // A negative threadCount picks one worker per hardware thread, minus the caller
+    explicit WorkerPool(int threadCount = -1) {
+        if (threadCount < 0) {
+            int hardwareThreads = (int)std::thread::hardware_concurrency();
+            threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+        for (int i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    unsigned getThreadCount() const { return (unsigned)workers.size() + 1; }
+
+    // Runs fn(0) .. fn(count - 1) across the pool and blocks until all are done.
+    // Indices are handed out dynamically, so fn must not depend on which thread runs it.
+    void parallelFor(int count, const std::function<void(int)>& fn) {
+        if (count <= 0) return;
+        if (workers.empty() || count == 1) {
+            for (int i = 0; i < count; ++i) fn(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &fn;
+            taskCount = count;
+            nextIndex.store(0, std::memory_order_relaxed);
+            activeWorkers = (int)workers.size();
+            ++generation;
+        }
+        wakeCondition.notify_all();
+
+        runTasks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [&] { return activeWorkers == 0; });
+        task = nullptr;
+    }
+};
+
+#endif